@@ -0,0 +1,37 @@
+#ifndef ADDRESSMAP_H_
+#define ADDRESSMAP_H_
+
+#include <stddef.h>
+
+/// Check that address is readable using cached copy of /proc/self/maps
+/// @param [in] pointer Pointer for check
+/// @return 1 if address is readable, 0 if is not and -1 if map is unavailable
+/// @note Map is reread only when address isn`t found in cached copy.\n
+/// Known ranges and mappings of files are trusted. Address in [heap] is checked with current end of heap,
+/// address in anonymous mapping is read by process_vm_readv(), because malloc() can unmap it
+int isAddressMapped(const void *pointer);
+
+/// Reread /proc/self/maps into cached copy
+/// @return Was map read
+int refreshAddressMap();
+
+/// Add range which is known as readable (for example stack`s array)
+/// @param [in] begin Begin of range
+/// @param [in] size Size of range in bytes
+/// @return Was range added, it isn`t only if memory for list of ranges wasn`t allocated
+/// @note Known ranges are checked before map by binary search
+int addKnownRange(const void *begin, size_t size);
+
+/// Remove range which was add with addKnownRange()
+/// @param [in] begin Begin of range
+/// @note Call before free memory of range
+void removeKnownRange(const void *begin);
+
+/// Forget memory which is unmapped, protected or released
+/// @param [in] begin Begin of memory
+/// @param [in] size Size of memory in bytes
+/// @note Known ranges inside of memory are removed and cached map is reread at next miss,
+/// so pointers into memory aren`t correct any more
+void forgetAddressRange(const void *begin, size_t size);
+
+#endif
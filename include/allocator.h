@@ -0,0 +1,117 @@
+#ifndef ALLOCATOR_H_
+#define ALLOCATOR_H_
+
+#include <stddef.h>
+#include <pthread.h>
+
+/// Interface of memory allocator for stack`s array
+/// @note Memory isn`t zeroed, stack fills it with poison itself.\n
+/// Size of memory is given to all functions, so backend doesn`t need headers
+typedef struct {
+  const char *name;
+
+  /// Get memory of size bytes aligned to alignment or nullptr
+  void *(*allocate)(void *context, size_t size, size_t alignment);
+
+  /// Change size of memory keeping first min(oldSize, newSize) bytes,
+  /// return nullptr and keep old memory if it is impossible
+  void *(*reallocate)(void *context, void *pointer, size_t oldSize, size_t newSize, size_t alignment);
+
+  /// Give memory back
+  void  (*deallocate)(void *context, void *pointer, size_t size);
+
+  void *context;
+} StackAllocator;
+
+/// Default allocator on top of malloc()
+/// @note Memory from LARGE_ARRAY_SIZE bytes is mapped by mmap() and grows by mremap(),
+/// so pages aren`t copied. Its alignment can`t be bigger than page.\n
+/// Smaller memory grows by realloc(), which can keep it in place
+extern const StackAllocator MALLOC_ALLOCATOR;
+
+/// Bump allocator in one block, for short-lived stacks
+/// @note Memory is given back only by arena_reset() or if it is last allocation.\n
+/// Not thread-safe
+typedef struct {
+  char  *memory;
+  size_t size;
+  size_t used;
+  size_t lastOffset; // Offset of last allocation, it can grow in place
+
+  StackAllocator allocator;
+} StackArena;
+
+/// Count of size classes in StackPool
+const int POOL_CLASSES_COUNT = 11;
+
+/// Size of smallest class of StackPool, next classes are twice bigger
+const size_t POOL_MIN_BLOCK = 64;
+
+/// Count of blocks in one slab of StackPool
+const size_t POOL_SLAB_BLOCKS = 16;
+
+/// Allocator with free lists of power-of-2 size classes, for many small stacks
+/// @note Blocks bigger than last class are taken from malloc().\n
+/// Thread-safe
+typedef struct {
+  void *freeLists[POOL_CLASSES_COUNT];
+  void *slabs;       // List of slabs for pool_destroy()
+
+  size_t slabsCount;
+
+  pthread_mutex_t lock;
+
+  StackAllocator allocator;
+} StackPool;
+
+/// Default size of address range which StackVmSpace reserves for each array
+const size_t DEFAULT_VM_RESERVE = (size_t)64 * 1024 * 1024 * 1024;
+
+/// Allocator which reserves big range of addresses for each array and commits its pages on demand
+/// @note Array is never moved: it grows and shrinks in place, so pointers to elements
+/// stay correct while stack lives. Pages after end of array are decommitted on shrink.\n
+/// Each array takes reserveSize of address space, so use it for few big stacks only
+/// (not for segmented ones, which allocate every chunk).\n
+/// Thread-safe
+typedef struct {
+  size_t reserveSize;
+
+  StackAllocator allocator;
+} StackVmSpace;
+
+/// Init arena
+/// @param [in/out] arena Pointer to arena
+/// @param [in] size Size of arena in bytes
+/// @param [out] error Return error code
+/// @note Use &arena->allocator as allocator of stacks
+void arena_init(StackArena *arena, size_t size, unsigned *error = nullptr);
+
+/// Forget all allocations of arena
+/// @param [in/out] arena Pointer to arena
+/// @note Call only when stacks using arena are destroyed.\n
+/// Arrays of stacks which weren`t destroyed aren`t correct pointers after it
+void arena_reset(StackArena *arena);
+
+/// Destroy arena
+/// @param [in/out] arena Pointer to arena
+void arena_destroy(StackArena *arena);
+
+/// Init pool
+/// @param [in/out] pool Pointer to pool
+/// @param [out] error Return error code
+/// @note Use &pool->allocator as allocator of stacks
+void pool_init(StackPool *pool, unsigned *error = nullptr);
+
+/// Destroy pool
+/// @param [in/out] pool Pointer to pool
+/// @note Call only when stacks using pool are destroyed
+void pool_destroy(StackPool *pool);
+
+/// Init space of virtual memory
+/// @param [in/out] space Pointer to space
+/// @param [in] reserveSize Size of address range for each array or 0 for DEFAULT_VM_RESERVE
+/// @param [out] error Return error code
+/// @note Use &space->allocator as allocator of stacks. Array can`t grow over reserveSize
+void vmspace_init(StackVmSpace *space, size_t reserveSize = 0, unsigned *error = nullptr);
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef CACHEDSTACK_H_
+#define CACHEDSTACK_H_
+
+#include <pthread.h>
+#include "stack.h"
+
+/// Counters of StackCache traffic
+typedef struct {
+  size_t localHits;        // Pushes and pops served by cache
+  size_t spills;           // Times cache gave batch to shared stack
+  size_t refills;          // Times cache took batch from shared stack
+  size_t spilledElements;
+  size_t refilledElements;
+} StackCacheStats;
+
+/// Stack shared by several threads, each of them works through own StackCache
+typedef struct {
+  Stack stack;
+
+  pthread_mutex_t lock;
+
+  StackCacheStats stats;   // Sum of stats of destroyed caches
+} SharedStack;
+
+/// Thread-local front cache of SharedStack
+/// @note Each thread must have own cache and must not give it to other threads
+typedef struct {
+  SharedStack *shared;
+
+  Element *elements;
+  size_t size;
+  size_t capacity;
+  size_t batch;
+
+  StackCacheStats stats;
+} StackCache;
+
+const size_t DEFAULT_CACHE_CAPACITY = 64;
+
+#define sharedstack_init(stk, capacity, copyFunction)            \
+  do_sharedstack_init(stk, capacity, copyFunction, INIT_INFO(stk))
+
+/// Init shared stack
+/// @param [in/out] stk Pointer to shared stack for init
+/// @param [in] capacity Start capacity for Stack
+/// @param [in] copyFunction Function for copy Elements
+/// @param [in] name Origin name of variable
+/// @param [in] fileName File name where was create variable
+/// @param [in] functionName Function name where was create variable
+/// @param [in] line Line where was create variable
+/// @param [out] error Return error code
+void do_sharedstack_init(SharedStack *stk, size_t capacity, void (*copyFunction)(Element *, const Element *),
+                         const char *name, const char *fileName, const char *functionName, int line,
+                         unsigned *error = nullptr);
+
+/// Destroy shared stack
+/// @param [in] stk Pointer to shared stack
+/// @param [out] error Return error code
+/// @note Call after destroy of all caches
+void sharedstack_destroy(SharedStack *stk, unsigned *error = nullptr);
+
+/// Get sum of stats of destroyed caches
+/// @param [in] stk Pointer to shared stack
+/// @param [out] stats Container for stats
+void sharedstack_stats(SharedStack *stk, StackCacheStats *stats);
+
+/// Init cache of shared stack
+/// @param [in/out] cache Pointer to cache
+/// @param [in] shared Pointer to shared stack
+/// @param [in] capacity Count of elements in cache or 0 for DEFAULT_CACHE_CAPACITY
+/// @param [out] error Return error code
+/// @note Cache spills and refills by half of capacity
+void stackcache_init(StackCache *cache, SharedStack *shared, size_t capacity, unsigned *error = nullptr);
+
+/// Destroy cache
+/// @param [in/out] cache Pointer to cache
+/// @param [out] error Return error code
+/// @note Elements from cache are pushed to shared stack.
+/// If shared stack can`t take them, cache isn`t destroyed and error is set
+void stackcache_destroy(StackCache *cache, unsigned *error = nullptr);
+
+/// Push one element through cache
+/// @param [in/out] cache Pointer to cache
+/// @param [in] element Pointer to element to push
+/// @param [out] error Return error code
+void stackcache_push(StackCache *cache, const Element *element, unsigned *error = nullptr);
+
+/// Pop one element through cache
+/// @param [in/out] cache Pointer to cache
+/// @param [out] element Container for pop-element
+/// @param [out] error Return error code
+/// @note If cache and shared stack are empty set error to 1
+void stackcache_pop(StackCache *cache, Element *element, unsigned *error = nullptr);
+
+/// Push all elements from cache to shared stack
+/// @param [in/out] cache Pointer to cache
+/// @param [out] error Return error code
+void stackcache_flush(StackCache *cache, unsigned *error = nullptr);
+
+#endif
@@ -7,6 +7,12 @@
 
 //#define HASH_OFF_
 
+#define INCREMENTAL_HASH_
+
+//#define LAZY_POISON_
+
+//#define GUARD_PAGES_
+
 //#define STACK_DUMP_OFF_
 
 //#define RELEASE_LOG_LEVEL_
@@ -14,6 +20,12 @@
 //#define MESSAGE_LOG_LEVEL_
 #define VALUE_LOG_LEVEL_
 
+//#define BINARY_LOG_
+
 typedef int Element;
 
+const size_t ARRAY_ALIGNMENT = 64; // Power of 2, not less than sizeof(unsigned) and alignof(Element)
+
+const size_t LARGE_ARRAY_SIZE = 64 * 1024 * 1024; // Arrays from this size in bytes are mapped and grow with mremap
+
 #endif
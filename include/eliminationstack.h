@@ -0,0 +1,83 @@
+#ifndef ELIMINATIONSTACK_H_
+#define ELIMINATIONSTACK_H_
+
+#include <atomic>
+#include "lockfreestack.h"
+
+const size_t CACHE_LINE_SIZE = 64;
+
+/// Cell of elimination arena where push gives element directly to pop
+typedef struct alignas(CACHE_LINE_SIZE) {
+  std::atomic<unsigned> state;
+
+  Element element;
+} EliminationSlot;
+
+/// LockFreeStack with elimination-backoff arena
+/// @note When CAS on top fails push offers element in random arena slot
+/// and pop looks for such offer, so pair of them finish without touching top
+typedef struct {
+  LockFreeStack stack;
+
+  EliminationSlot *arena;
+  size_t arenaSize;
+
+  unsigned backoff;
+
+  std::atomic<size_t> eliminations;
+} EliminationStack;
+
+const size_t   DEFAULT_ARENA_SIZE = 16;
+const unsigned DEFAULT_BACKOFF    = 256;
+
+#define elimination_init(stk, capacity, copyFunction, arenaSize, backoff)      \
+  do_elimination_init(stk, capacity, copyFunction, arenaSize, backoff, INIT_INFO(stk))
+
+/// Init elimination stack
+/// @param [in/out] stk Pointer to stack for init
+/// @param [in] capacity Max count of elements in stack
+/// @param [in] copyFunction Function for copy Elements
+/// @param [in] arenaSize Count of arena slots or 0 for DEFAULT_ARENA_SIZE
+/// @param [in] backoff Count of spins which push and pop wait in arena or 0 for DEFAULT_BACKOFF
+/// @param [in] name Origin name of variable
+/// @param [in] fileName File name where was create variable
+/// @param [in] functionName Function name where was create variable
+/// @param [in] line Line where was create variable
+/// @param [out] error Return error code
+/// @note Arena size about half of count of threads is good start for tuning
+void do_elimination_init(EliminationStack *stk, size_t capacity,
+                         void (*copyFunction)(Element *, const Element *),
+                         size_t arenaSize, unsigned backoff,
+                         const char *name, const char *fileName, const char *functionName, int line,
+                         unsigned *error = nullptr);
+
+/// Destroy elimination stack
+/// @param [in] stk Pointer to stack for destroy
+/// @param [out] error Return error code
+void elimination_destroy(EliminationStack *stk, unsigned *error = nullptr);
+
+/// Push one element to stack
+/// @param [in/out] stk Pointer to stack
+/// @param [in] element Pointer to element to push
+/// @param [out] error Return error code
+void elimination_push(EliminationStack *stk, const Element *element, unsigned *error = nullptr);
+
+/// Pop one element from stack
+/// @param [in/out] stk Pointer to stack
+/// @param [out] element Container for pop-element
+/// @param [out] error Return error code
+/// @note If stack is empty set error to 1
+void elimination_pop(EliminationStack *stk, Element *element, unsigned *error = nullptr);
+
+/// Size of stack
+/// @param [in] stk Pointer to stack
+/// @param [out] error Return error code
+/// @return Count of elements at moment of call
+size_t elimination_size(const EliminationStack *stk, unsigned *error = nullptr);
+
+/// Count of push/pop pairs which were finished in arena
+/// @param [in] stk Pointer to stack
+/// @return Count of eliminations
+size_t elimination_count(const EliminationStack *stk);
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef GUARDPAGES_H_
+#define GUARDPAGES_H_
+
+#include <stddef.h>
+#include "stack.h"
+
+/// Count of arrays with guard pages which can live at once
+const int GUARD_REGIONS_COUNT = 64;
+
+/// Allocate zeroed memory between two PROT_NONE pages
+/// @param [in] size Size of memory in bytes
+/// @param [in] owner Stack which will use memory, it is named in report about fault
+/// @return Pointer to memory or nullptr if was error
+/// @note End of memory touches right guard page, so any write after it faults at once.\n
+/// Left guard page is at start of first page, so small underflow can be missed.\n
+/// First call sets SIGSEGV handler, which prints report about stack and calls old handler
+void *guardAlloc(size_t size, const Stack *owner);
+
+/// Free memory from guardAlloc()
+/// @param [in] data Pointer to memory
+/// @param [in] size Size from guardAlloc()
+void guardFree(void *data, size_t size);
+
+#endif
@@ -3,10 +3,49 @@
 
 #include <stddef.h>
 
+/// Families of hash functions
+enum HASH_FAMILY {
+  HASH_DJB,    // Old byte-at-a-time hash, same as getHash(). Only last 32 bytes change it
+  HASH_CRC32C, // CRC32C, uses SSE4.2 crc32 instruction if CPU has it
+  HASH_XXH32,  // xxHash32, uses SSE4.1 for four lanes if CPU has it
+};
+
 /// Calc hash for data
 /// @param [in] data Data which need hash
 /// @param [in] size Size of data
 /// @return Hash of data
 unsigned getHash(const void *data, size_t size);
 
+/// Calc hash for data with chosen family
+/// @param [in] data Data which need hash
+/// @param [in] size Size of data
+/// @param [in] family Family of hash function
+/// @return Hash of data
+/// @note Vector and scalar versions of one family give same hash
+unsigned getFamilyHash(const void *data, size_t size, HASH_FAMILY family);
+
+/// Name of hash family
+/// @param [in] family Family of hash function
+/// @return Name or "UNKNOWN"
+const char *hashFamilyName(HASH_FAMILY family);
+
+/// Calc contribution of one array slot to array hash
+/// @param [in] data Pointer to slot
+/// @param [in] size Size of slot
+/// @param [in] index Index of slot in array
+/// @param [in] family Family of hash function
+/// @return Hash of slot which depends on its position
+/// @note Don`t check pointer, caller must give correct slot
+unsigned getSlotHash(const void *data, size_t size, size_t index, HASH_FAMILY family);
+
+/// Calc position-weighted hash of array
+/// @param [in] array Pointer to first slot
+/// @param [in] count Count of slots
+/// @param [in] elementSize Size of one slot
+/// @param [in] family Family of hash function
+/// @param [in] firstIndex Index of first slot in whole array
+/// @return Sum of getSlotHash() for all slots
+/// @note One slot can be changed in O(1): subtract its old getSlotHash() and add new
+unsigned getArrayHash(const void *array, size_t count, size_t elementSize, HASH_FAMILY family, size_t firstIndex = 0);
+
 #endif
@@ -0,0 +1,168 @@
+#ifndef LOCKFREESTACK_H_
+#define LOCKFREESTACK_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <atomic>
+#include "stack.h"
+
+/// Node of LockFreeStack
+typedef struct {
+  Element element;
+
+  std::atomic<uint32_t> next;
+} LockFreeNode;
+
+/// Treiber stack which can be used from several threads without locks
+/// @note Nodes are taken from pool with fixed capacity.\n
+/// Heads are tagged by counter of changes, so ABA is impossible
+typedef struct {
+#ifndef RELEASE_BUILD_
+
+  CANARY leftCanary;
+
+#endif
+
+  LockFreeNode *nodes;
+  size_t capacity;
+
+  std::atomic<uint64_t> top;
+  std::atomic<uint64_t> freeList;
+  std::atomic<size_t>   size;
+
+  void (*copyFunction)(Element *, const Element *);
+
+  unsigned status;
+
+#ifndef RELEASE_BUILD_
+
+  DebugInfo info;
+
+  CANARY rightCanary;
+
+#endif
+} LockFreeStack;
+
+/// Chech valid of lock-free stack
+/// @param [in] stk Pointer to stack
+/// @return Code of error from ERROR
+/// @note Check only canaries and fields which don`t change after init,\n
+/// so it is safe to call it from any thread
+unsigned lockfree_valid(const LockFreeStack *stk);
+
+#define lockfree_init(stk, capacity, copyFunction)              \
+  do_lockfree_init(stk, capacity, copyFunction, INIT_INFO(stk))
+
+/// Init lock-free stack
+/// @param [in/out] stk Pointer to stack for init
+/// @param [in] capacity Max count of elements in stack
+/// @param [in] copyFunction Function for copy Elements
+/// @param [in] name Origin name of variable
+/// @param [in] fileName File name where was create variable
+/// @param [in] functionName Function name where was create variable
+/// @param [in] line Line where was create variable
+/// @param [out] error Return error code
+/// @note Call before all using and before start of other threads
+void do_lockfree_init(LockFreeStack *stk, size_t capacity,
+                      void (*copyFunction)(Element *, const Element *),
+                      const char *name, const char *fileName, const char *functionName, int line,
+                      unsigned *error = nullptr);
+
+/// Destroy lock-free stack
+/// @param [in] stk Pointer to stack for destroy
+/// @param [out] error Return error code
+/// @note Call after all threads stop using stack
+void lockfree_destroy(LockFreeStack *stk, unsigned *error = nullptr);
+
+/// Push one element to stack
+/// @param [in/out] stk Pointer to stack
+/// @param [in] element Pointer to element to push
+/// @param [out] error Return error code
+/// @note If stack is full set error to 1
+void lockfree_push(LockFreeStack *stk, const Element *element, unsigned *error = nullptr);
+
+/// Pop one element from stack
+/// @param [in/out] stk Pointer to stack
+/// @param [out] element Container for pop-element
+/// @param [out] error Return error code
+/// @note If stack is empty set error to 1
+void lockfree_pop(LockFreeStack *stk, Element *element, unsigned *error = nullptr);
+
+/// Results of lockfree_tryPush() and lockfree_tryPop()
+enum LOCKFREE_TRY {
+  LOCKFREE_CONTENTION = 0,
+  LOCKFREE_DONE       = 1,
+};
+
+/// Try to push one element to stack with single CAS
+/// @param [in/out] stk Pointer to stack
+/// @param [in] element Pointer to element to push
+/// @param [out] error Return error code
+/// @return LOCKFREE_DONE if operation was finished (also with error) or LOCKFREE_CONTENTION if CAS failed
+/// @note Used by wrappers which do something useful instead of retrying CAS
+int lockfree_tryPush(LockFreeStack *stk, const Element *element, unsigned *error = nullptr);
+
+/// Try to pop one element from stack with single CAS
+/// @param [in/out] stk Pointer to stack
+/// @param [out] element Container for pop-element
+/// @param [out] error Return error code
+/// @return LOCKFREE_DONE if operation was finished (also with error) or LOCKFREE_CONTENTION if CAS failed
+int lockfree_tryPop(LockFreeStack *stk, Element *element, unsigned *error = nullptr);
+
+/// Take free node and copy element into it
+/// @param [in/out] stk Pointer to stack
+/// @param [in] element Pointer to element to push
+/// @param [out] error Return error code
+/// @return Index of node plus one or 0 if node wasn`t taken
+/// @note If stack is full set error to 1.\n
+/// Node is counted in size until it is given back by lockfree_releaseNode()
+uint32_t lockfree_takeNode(LockFreeStack *stk, const Element *element, unsigned *error = nullptr);
+
+/// Try to push node from lockfree_takeNode() with single CAS
+/// @param [in/out] stk Pointer to stack
+/// @param [in] number Index of node plus one
+/// @return LOCKFREE_DONE if node was pushed or LOCKFREE_CONTENTION if CAS failed
+/// @note On contention node still belongs to caller, so retries don`t touch free list
+int lockfree_tryPushNode(LockFreeStack *stk, uint32_t number);
+
+/// Give node from lockfree_takeNode() back to free list
+/// @param [in/out] stk Pointer to stack
+/// @param [in] number Index of node plus one
+/// @note Used when element was passed to pop in other way
+void lockfree_releaseNode(LockFreeStack *stk, uint32_t number);
+
+/// Size of stack
+/// @param [in] stk Pointer to stack
+/// @param [out] error Return error code
+/// @return Count of elements at moment of call
+size_t lockfree_size(const LockFreeStack *stk, unsigned *error = nullptr);
+
+/// Check that stack is empty
+/// @param [in] stk Pointer to stack
+/// @param [out] error Return error code
+/// @return 1 if stack was empty at moment of call or 0 if was not
+int lockfree_isEmpty(const LockFreeStack *stk, unsigned *error = nullptr);
+
+#ifndef RELEASE_BUILD_
+
+#define lockfree_dump(stk, errorCode, filePtr)          \
+  do_lockfree_dump(stk, errorCode, filePtr, LINE_INFO)
+
+#else
+
+#define lockfree_dump(stk, errorCode, filePtr) ;
+
+#endif
+
+/// Dump lock-free stack into file
+/// @param [in] stk Pointer to stack for dump
+/// @param [in] errorCode Code from lockfree_valid()
+/// @param [in] filePtr File for logging
+/// @param [in] fileName Name of file where was call function
+/// @param [in] functionName Name of function where was call function
+/// @param [in] line Line where was call function
+/// @note Don`t print elements, because other threads can change them
+void do_lockfree_dump(const LockFreeStack *stk, unsigned errorCode, FILE *filePtr,
+                      const char *fileName, const char *functionName, int line);
+
+#endif
@@ -7,14 +7,29 @@
 #ifndef LOGGING_H_
 #define LOGGING_H_
 
-#define LOG_INFO(EXPRESSION) #EXPRESSION, __FILE__, __func__, __LINE__
+#include <stdio.h>
+#include <stdint.h>
+#include <atomic>
+#include "conf.h"
+#include "timestamp.h"
 
 #define LOG_DIRECTORY ".log/"
 
+/// Environment variable with rules of call sites
+#define LOG_SITES_ENV "STACK_LOG_SITES"
+
+/// File with rules of call sites, it is read again when it changes
+#define LOG_CONTROL_FILE LOG_DIRECTORY "control"
+
 #define LOG_FILE_PREFIX "log"
 
 #define LOG_FILE_SUFFIX "txt"
 
+#define LOG_BINARY_FILE_SUFFIX "bin"
+
+/// First bytes of binary log file
+#define LOG_BINARY_MAGIC "STKBLOG1"
+
 unsigned enum LogLevel {
   FATAL   = (0x01 << 0),
   ERROR   = (0x01 << 1),
@@ -23,25 +38,204 @@ unsigned enum LogLevel {
   VALUE   = (0x01 << 4),
 };
 
+/// Levels of log which are compiled
+#if   defined RELEASE_LOG_LEVEL_
+
+constexpr unsigned STATIC_LOG_LEVEL = FATAL;
+
+#elif defined ERROR_LOG_LEVEL_
+
+constexpr unsigned STATIC_LOG_LEVEL = FATAL | ERROR;
+
+#elif defined MESSAGE_LOG_LEVEL_
+
+constexpr unsigned STATIC_LOG_LEVEL = FATAL | ERROR | MESSAGE;
+
+#elif defined VALUE_LOG_LEVEL_
+
+constexpr unsigned STATIC_LOG_LEVEL = FATAL | ERROR | MESSAGE | VALUE;
+
+#else
+
+constexpr unsigned STATIC_LOG_LEVEL = 0;
+
+#endif
+
+/// States of call site
+enum LOG_SITE_STATE {
+  LOG_SITE_UNKNOWN, // Rules aren`t checked yet
+  LOG_SITE_ON,
+  LOG_SITE_OFF,
+};
+
+/// Call site of log macro
+/// @note Each macro has static LogSite, which is registered at first call.\n
+/// Site is turned off by rules from LOG_SITES_ENV and LOG_CONTROL_FILE. Rules are separated by
+/// commas, spaces or new lines, each is '+' or '-' and pattern: '*', name of file, name of file
+/// and line ("stack.cpp:120") or name of function. Last matching rule wins, fatal sites are always on
+typedef struct LogSite {
+  const char      *name;
+  const char      *fileName;
+  const char      *functionName;
+  int              line;
+  unsigned         level;
+
+  std::atomic<int> state; // State from LOG_SITE_STATE
+
+  struct LogSite  *next;  // Next registered site
+} LogSite;
+
+#define LOG_SITE_PRINT(LEVEL, VALUE, NAME)                                                     \
+  do                                                                                           \
+    {                                                                                          \
+      static LogSite LOG_SITE_TEMP = {NAME, __FILE__, __func__, __LINE__, LEVEL,               \
+                                      {LOG_SITE_UNKNOWN}, nullptr};                            \
+                                                                                               \
+      if ((STATIC_LOG_LEVEL & (LEVEL)) &&                                                      \
+          __builtin_expect(LOG_SITE_TEMP.state.load(std::memory_order_relaxed) != LOG_SITE_OFF, 1)) \
+        loggingPrint(&LOG_SITE_TEMP, VALUE);                                                   \
+    } while (0)
+
+/// Types of records of binary log
+/// @note Binary log is LOG_BINARY_MAGIC and records, each is LogRecordHeader and body
+enum LOG_RECORD {
+  LOG_RECORD_TEXT,  // Text of dumps and separators, body is text
+  LOG_RECORD_SITE,  // Call site of log function, body is LogSiteRecord and C-like strings name, fileName, functionName
+  LOG_RECORD_VALUE, // Call of log function, body is LogValueRecord and value
+};
+
+/// Types of values in LOG_RECORD_VALUE
+enum LOG_VALUE {
+  LOG_VALUE_LONG_LONG, // long long
+  LOG_VALUE_DOUBLE,    // double
+  LOG_VALUE_CHAR,      // char
+  LOG_VALUE_POINTER,   // uint64_t with address
+  LOG_VALUE_STRING,    // Text without '\0', size is given by header
+};
+
+/// Header of record of binary log
+typedef struct {
+  uint8_t  type;      // Type from LOG_RECORD
+  uint8_t  level;     // Level from LogLevel for LOG_RECORD_VALUE
+  uint8_t  valueType; // Type from LOG_VALUE for LOG_RECORD_VALUE
+  uint8_t  reserved;
+  uint32_t size;      // Size of body, record with header is never bigger than LOG_BUFFER_SIZE
+} LogRecordHeader;
+
+/// Start of body of LOG_RECORD_SITE
+/// @note Site is written once to each file, before its first value
+typedef struct {
+  uint32_t site;
+  int32_t  line;
+} LogSiteRecord;
+
+/// Count of call sites in binary log, ids of sites are less than it
+const uint32_t LOG_SITES_COUNT = 4096;
+
+/// Start of body of LOG_RECORD_VALUE
+/// @note Records are packed, so fields must be read by memcpy()
+typedef struct {
+  uint64_t time; // Nanoseconds from Epoch, precision is set by setLogPrecision()
+  uint32_t site;
+} __attribute__((packed)) LogValueRecord;
+
+/// What producer does if ring buffer of log is full
+enum LOG_OVERFLOW {
+  LOG_OVERFLOW_BLOCK, // Wait until writer thread frees place
+  LOG_OVERFLOW_DROP,  // Lose text silently
+  LOG_OVERFLOW_COUNT, // Lose text and write count of lost bytes into log
+};
+
+/// Size of ring buffer between logging threads and writer thread in bytes, power of 2
+const size_t LOG_BUFFER_SIZE = 1024 * 1024;
+
+/// Statistics of log writer
+typedef struct {
+  uint64_t bytes;        // Bytes written to file
+  uint64_t writes;       // Calls of write()
+  uint64_t droppedBytes; // Bytes lost because buffer was full
+  uint64_t blocks;       // Times when thread waited for place in buffer
+  uint64_t rotations;    // Times when new file was opened
+} LogStats;
+
+/// Default size of log file in bytes after which new file is opened
+const size_t DEFAULT_MAX_LOG_FILE_SIZE = 256 * 1024 * 1024;
+
+/// Default age of log file in seconds after which new file is opened
+const unsigned DEFAULT_LOG_FILE_SECONDS = 60 * 60;
+
+/// When new log file is opened
+enum LOG_ROTATION {
+  LOG_ROTATION_SIZE, // When file reaches maxFileSize bytes
+  LOG_ROTATION_TIME, // When file is older than fileSeconds
+};
+
+/// Policy of log rotation, zero fields mean default values
+typedef struct {
+  LOG_ROTATION rotation;
+  size_t       maxFileSize; // DEFAULT_MAX_LOG_FILE_SIZE if 0
+  unsigned     fileSeconds; // DEFAULT_LOG_FILE_SECONDS if 0
+  unsigned     keepFiles;   // Count of closed files which are kept, all if 0
+  int          compress;    // Compress closed files by gzip in background
+} LogRotation;
+
 /// Getter for LOG_FILE
 /// @return LOG_FILE or NULL if fail to open file
-/// @note If log file bigger than 1GB close it and open new file and save descriptor in LOG_FILE\n
+/// @note When rotation policy says, text after this call goes to new file.
+/// Size of file is counted by log itself, so call doesn`t make syscalls.\n
 /// If was error in open file set LOG_LEVEL to 0
+/// @note Text printed to LOG_FILE is put into ring buffer and is written to file
+/// by writer thread, so printing doesn`t wait for disk.\n
+/// With BINARY_LOG_ file is binary log, text is saved in LOG_RECORD_TEXT records
 FILE *getLogFile();
 
+/// Set policy of log rotation
+/// @param [in] policy Pointer to policy, by default file is changed after DEFAULT_MAX_LOG_FILE_SIZE bytes
+/// @param [out] error Return error code
+/// @note keepFiles counts files closed by this process only, older files are deleted by writer thread.\n
+/// Size of file is kept during bursts too: up to 8 new files can wait for writer,
+/// then thread which changes file waits for it.\n
+/// At exit log waits for running gzip processes
+void setLogRotation(const LogRotation *policy, unsigned *error = nullptr);
+
+/// Set what to do if ring buffer of log is full
+/// @param [in] policy Policy from LOG_OVERFLOW, LOG_OVERFLOW_BLOCK by default
+void setLogOverflow(LOG_OVERFLOW policy);
+
+/// Set precision of time in log lines and records of binary log
+/// @param [in] precision Precision from TIMESTAMP_PRECISION, TIMESTAMP_SECONDS by default
+void setLogPrecision(TIMESTAMP_PRECISION precision);
+
+/// Wait until all text printed before call is written to file
+/// @note Autocallable at exit and after logFatal
+void flushLog();
+
+/// Get statistics of log writer
+/// @param [out] stats Pointer to statistics
+void getLogStats(LogStats *stats);
+
+/// Read rules of call sites again and apply them to all registered sites
+/// @note Autocallable when LOG_CONTROL_FILE changes
+void reloadLogSites();
+
+/// Register call site at first call and check if it is on
+/// @param [in/out] site Pointer to site
+/// @return Is site on
+int isLogSiteOn(LogSite *site);
+
 #ifndef RELEASE_BUILD_
 
 #define logValue(value)                                     \
-  loggingPrint(VALUE   , value      , LOG_INFO(value))
+  LOG_SITE_PRINT(VALUE  , value      , #value)
 
 #define logMessage(message)                                 \
-  loggingPrint(MESSAGE , message    , LOG_INFO(message))
+  LOG_SITE_PRINT(MESSAGE, message    , #message)
 
 #define logWarning(warning)                                 \
-  logggingPrint(WARNING, #warning   , LOG_INFO(warning))
+  LOG_SITE_PRINT(WARNING, #warning   , #warning)
 
 #define logError(expression)                                \
-  loggingPrint(ERROR   , #expression, LOG_INFO(expression))
+  LOG_SITE_PRINT(ERROR  , #expression, #expression)
 
 #else
 
@@ -56,7 +250,7 @@ FILE *getLogFile();
 #endif
 
 #define logFatal(expression)                              \
-  loggingPrint(FATAL, #expression, LOG_INFO(expression))
+  LOG_SITE_PRINT(FATAL  , #expression, #expression)
 
 
 /// Print log info for decimal
@@ -114,6 +308,17 @@ int loggingPrint(unsigned level, const void *value,const char *name,
 int loggingPrint(unsigned level, const char *value, const char *name,
                  const char *fileName, const char *functionName, int line);
 
-#undef LOG_INFO
+/// Print log info for call site of log macro
+/// @param [in/out] site Pointer to site
+/// @param [in] value Value
+/// @return Count of print chars
+template <typename T>
+inline int loggingPrint(LogSite *site, T value)
+{
+  if (!isLogSiteOn(site))
+    return 0;
+
+  return loggingPrint(site->level, value, site->name, site->fileName, site->functionName, site->line);
+}
 
 #endif
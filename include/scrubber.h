@@ -0,0 +1,52 @@
+#ifndef SCRUBBER_H_
+#define SCRUBBER_H_
+
+#include <stdint.h>
+#include "stack.h"
+
+/// Settings of scrubber thread
+/// @note Zero fields mean default values
+typedef struct {
+  size_t   chunkElements;  // Count of elements which are hashed under one lock
+  unsigned intervalMs;     // Pause between passes over all stacks
+  size_t   bytesPerSecond; // Max speed of reading arrays
+  unsigned cpuPercent;     // Max part of one CPU which scrubber can use (1-100)
+} ScrubberPolicy;
+
+/// Counters of scrubber thread
+typedef struct {
+  uint64_t passes;         // Finished passes over all stacks
+  uint64_t stacks;         // Stacks which were checked completely
+  uint64_t chunks;         // Hashed chunks
+  uint64_t bytes;          // Hashed bytes
+  uint64_t mismatches;     // Checks which found errors
+  uint64_t restarts;       // Checks started again, because stack was changed between chunks
+  uint64_t skipped;        // Checks given up till next pass, because stack was changed too often
+  uint64_t cpuNanoseconds; // CPU time of scrubber thread
+} ScrubberStats;
+
+/// Max count of restarts of check of one stack in one pass
+const unsigned MAX_SCRUB_RESTARTS = 4;
+
+/// Start scrubber thread
+/// @param [in] policy Settings or nullptr for default settings
+/// @param [out] error Return error code
+/// @note Scrubber checks stacks registered in validation list (see validation.h),
+/// so only stacks initialized while scrubber or background validation works.\n
+/// It checks canaries and array hash, hashing array by chunks,
+/// and dumps stack into log if it finds error.\n
+/// Push and pop never wait for scrubber, resize waits for one chunk at most.\n
+/// If stack is changed during check, check starts again with twice bigger chunks.
+/// After MAX_SCRUB_RESTARTS restarts stack is skipped till next pass,
+/// so one chunk is never bigger than chunkElements * 2^MAX_SCRUB_RESTARTS
+void scrubber_start(const ScrubberPolicy *policy = nullptr, unsigned *error = nullptr);
+
+/// Stop scrubber thread
+/// @note Waits for end of current chunk
+void scrubber_stop();
+
+/// Get counters of scrubber
+/// @param [out] stats Container for counters
+void scrubber_stats(ScrubberStats *stats);
+
+#endif
@@ -4,6 +4,8 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include "conf.h"
+#include "hash.h"
+#include "allocator.h"
 
 #define LINE_INFO __FILE__, __func__, __LINE__
 #define INIT_INFO(VALUE) #VALUE + 1, LINE_INFO
@@ -17,6 +19,31 @@ typedef struct {
 
 typedef unsigned CANARY;
 
+#define LEFT_CANARY        0xDEADBEAF
+#define RIGHT_CANARY       0xBADC0FEE
+#define LEFT_ARRAY_CANARY  0xBEADFACE
+#define RIGHT_ARRAY_CANARY 0xABADBABE
+
+#if !defined(RELEASE_BUILD_) && !defined(GUARD_PAGES_) && !defined(CANARIES_OFF_)
+
+#define ARRAY_CANARIES_
+
+#endif
+
+/// Policy of growth and shrink of Stack`s array
+/// @note Zero fields mean default values
+typedef struct {
+  size_t growthFactor;  // Capacity is multiplied by it when array is full
+  size_t shrinkDivider; // Array shrinks when size * shrinkDivider <= capacity
+  size_t minCapacity;   // Auto-shrink never makes capacity less
+  int    neverShrink;   // Turn off auto-shrink
+} GrowthPolicy;
+
+/// Default values of GrowthPolicy
+const size_t DEFAULT_STACK_GROWTH   =  2;
+const size_t DEFAULT_STACK_SHRINK   =  4;
+const size_t DEFAULT_STACK_CAPACITY = 10;
+
 typedef struct {
 #ifndef RELEASE_BUILD_
 
@@ -24,18 +51,44 @@ typedef struct {
 
 #endif
 
-  Element *array;
+  Element *array;        // nullptr if stack is segmented
+
+  Element **chunks;      // Directory of chunks if stack is segmented
+  size_t chunksSize;     // Count of pointers in directory
+  Element *spareChunk;   // Free chunk kept after pop, so push on border of chunk doesn`t allocate
+  size_t chunkElements;  // Count of elements in chunk (power of 2) or 0 if stack isn`t segmented
+  size_t chunkShift;     // log2(chunkElements)
+
   size_t capacity;
   size_t lastElementIndex;
 
+#ifdef LAZY_POISON_
+
+  size_t poisonedFrom; // Slots from this index are poison, but may be not written
+
+#endif
+
   void (*copyFunction)(Element *, const Element *);
 
+  const StackAllocator *allocator;
+
   unsigned status;
 
+  GrowthPolicy growth;
+
+  size_t reservedCapacity;
+
+  size_t growCount;
+  size_t shrinkCount;
+
 #ifndef RELEASE_BUILD_
 
   DebugInfo info;
 
+  HASH_FAMILY hashFamily;
+
+  int validationSlot; // Slot in list of background validation or -1
+
   mutable unsigned hash;
   mutable unsigned arrayHash;
 
@@ -68,13 +121,14 @@ unsigned enum ERROR {
   NOT_FUNCTION_NAME               = 0X01 << 12,
   INCORRECT_LINE                  = 0x01 << 13,
   DIFFERENT_HASH                  = 0x01 << 14,
-  DIFFERENT_ARRAY_HASH            = 0x01 << 15
+  DIFFERENT_ARRAY_HASH            = 0x01 << 15,
+  INCORRECT_POISON_BORDER         = 0x01 << 16
 };
 
 const unsigned NOT_EMPTY = -1u ^ (0x01 << 2);
 
 const unsigned STATUS_COUNT = 3;
-const unsigned ERRORS_COUNT = 16;
+const unsigned ERRORS_COUNT = 17;
 
 enum DUMP_LEVEL {
   DUMP_ALL,
@@ -89,13 +143,47 @@ extern DUMP_LEVEL DUMP_LVL;
 /// @return Code of error
 unsigned stack_valid(const Stack *stk);
 
+/// Check canaries of stack`s array or of all chunks
+/// @param [in] stk Pointer to stack
+/// @return LEFT_ARRAY_CANARY_DIED, RIGHT_ARRAY_CANARY_DIED or 0
+/// @note Without ARRAY_CANARIES_ always 0
+unsigned stack_arrayCanaries(const Stack *stk);
+
+/// Calc hash of stack`s array as it is kept in arrayHash
+/// @param [in] stk Pointer to stack
+/// @return Hash of all slots
+unsigned stack_arrayHash(const Stack *stk);
+
+/// Get slot of stack
+/// @param [in] stk Pointer to stack
+/// @param [in] index Index of slot, less than capacity
+/// @return Pointer to slot
+const Element *stack_slot(const Stack *stk, size_t index);
+
+/// Get count of slots from index which are in one block of memory
+/// @param [in] stk Pointer to stack
+/// @param [in] index Index of slot, less than capacity
+/// @return Count of slots till end of array or of chunk
+size_t stack_slotsRun(const Stack *stk, size_t index);
+
+/// Check that slot of stack is free and has poison
+/// @param [in] stk Pointer to stack
+/// @param [in] index Index of slot in array
+/// @return 1 if slot is poison or 0 if it isn`t
+/// @note With LAZY_POISON_ slots after poisonedFrom are poison without reading them
+int stack_isPoisonSlot(const Stack *stk, size_t index);
+
 #define stack_init(stk, capacity, copyFunction)          \
-  do_stack_init(stk, capacity, copyFunction, INIT_INFO(stk))
+  do_stack_init(stk, capacity, copyFunction, nullptr, INIT_INFO(stk))
+
+#define stack_initWithAllocator(stk, capacity, copyFunction, allocator)          \
+  do_stack_init(stk, capacity, copyFunction, allocator, INIT_INFO(stk))
 
 /// Init Stack
 /// @param [in/out] stk Pointer to stack for init
 /// @param [in] capacity Start capacity for Stack
 /// @param [in] copyFunction Function for copy Elements
+/// @param [in] allocator Allocator for array or nullptr for MALLOC_ALLOCATOR
 /// @param [in] name Origin name of variable
 /// @param [in] fileName File name where was create variable
 /// @param [in] functionName Function name where was create variable
@@ -103,6 +191,7 @@ unsigned stack_valid(const Stack *stk);
 /// @param [out] error Return error code
 /// @note Call before all using
 void do_stack_init(Stack *stk, size_t capacity, void (*copyFunction)(Element *, const Element *),
+                  const StackAllocator *allocator,
                   const char *name, const char *fileName, const char *functionName, int line,
                   unsigned *error = nullptr);
 
@@ -124,6 +213,24 @@ void stack_push(Stack *stk, const Element *element, unsigned *error = nullptr);
 /// @param [out] error Return error code
 void stack_pop(Stack *stk, Element *element, unsigned *error = nullptr);
 
+/// Push count elements to stack
+/// @param [in/out] stk Pointer to stack
+/// @param [in] elements Pointer to first element to push
+/// @param [in] count Count of elements
+/// @param [out] error Return error code
+/// @note Stack is resized, validated and rehashed once per call.\n
+/// Trivially copyable Elements are copied with memcpy instead of copyFunction
+void stack_push_n(Stack *stk, const Element *elements, size_t count, unsigned *error = nullptr);
+
+/// Pop count elements from stack
+/// @param [in/out] stk Pointer to stack
+/// @param [out] elements Container for count pop-elements
+/// @param [in] count Count of elements
+/// @param [out] error Return error code
+/// @note Elements are written in order they were pushed,\n
+/// so stack_pop_n() after stack_push_n() with same count returns same array
+void stack_pop_n(Stack *stk, Element *elements, size_t count, unsigned *error = nullptr);
+
 /// Resize Stack`s array to new size
 /// @param [in/out] stk Pointer to stack for resize
 /// @param [in] newSize New size for Stack in Elements
@@ -131,6 +238,59 @@ void stack_pop(Stack *stk, Element *element, unsigned *error = nullptr);
 /// @note Functioun itself multiplay to sizeof(Element)
 void stack_resize(Stack *stk, size_t newSize, unsigned *error = nullptr);
 
+/// Keep stack in chunks of fixed size instead of one array
+/// @param [in/out] stk Pointer to empty stack
+/// @param [in] chunkElements Count of elements in chunk, power of 2 or 0 for default
+/// @param [out] error Return error code
+/// @note Push and pop never move elements, capacity grows and shrinks by whole chunks.\n
+/// Free chunks are given back at once, but one of them is kept, so push and pop\n
+/// on border of chunk don`t allocate and free memory. Reserve and pin are kept
+void stack_setSegmented(Stack *stk, size_t chunkElements, unsigned *error = nullptr);
+
+/// Set policy of growth and shrink
+/// @param [in/out] stk Pointer to stack
+/// @param [in] policy Pointer to policy
+/// @param [out] error Return error code
+/// @note Policy is incorrect if shrinkDivider isn`t bigger than growthFactor,\n
+/// because then pop after push can shrink array back and push after pop can grow it
+void stack_setGrowthPolicy(Stack *stk, const GrowthPolicy *policy, unsigned *error = nullptr);
+
+/// Reserve place for n elements
+/// @param [in/out] stk Pointer to stack
+/// @param [in] n Count of elements
+/// @param [out] error Return error code
+/// @note Array is resized at most once. After that stack isn`t reallocated
+/// while its size is not bigger than n: auto-shrink never goes below n
+void stack_reserve(Stack *stk, size_t n, unsigned *error = nullptr);
+
+/// Pin or unpin capacity of stack
+/// @param [in/out] stk Pointer to stack
+/// @param [in] pin 1 to turn off auto-shrink, 0 to turn it on
+/// @param [out] error Return error code
+/// @note Same as neverShrink in GrowthPolicy
+void stack_pinCapacity(Stack *stk, int pin, unsigned *error = nullptr);
+
+/// Shrink array to size of stack
+/// @param [in/out] stk Pointer to stack
+/// @param [out] error Return error code
+/// @note Drop reservation from stack_reserve(). Array is resized at most once
+void stack_shrink_to_fit(Stack *stk, unsigned *error = nullptr);
+
+/// Set family of hash function for stack
+/// @param [in/out] stk Pointer to stack
+/// @param [in] family Family of hash function
+/// @param [out] error Return error code
+/// @note Stack and array are rehashed at once. With INCREMENTAL_HASH_ family
+/// hashes each slot, array hash is sum of slot hashes
+void stack_setHashFamily(Stack *stk, HASH_FAMILY family, unsigned *error = nullptr);
+
+/// Get count of resizes of Stack`s array
+/// @param [in] stk Pointer to stack
+/// @param [out] grows Count of resizes which made array bigger
+/// @param [out] shrinks Count of resizes which made array smaller
+/// @param [out] error Return error code
+void stack_resizeCount(const Stack *stk, size_t *grows, size_t *shrinks, unsigned *error = nullptr);
+
 /// Size of Stack
 /// @param [in] stk Pointer to stack
 /// @param [out] error Return error code
@@ -171,4 +331,10 @@ int stack_isEmpty(const Stack *stk, unsigned *error = nullptr);
 void do_stack_dump(const Stack *stk, unsigned errorCode, FILE *filePtr,
                    const char *fileName, const char *functionName, int line);
 
+/// Print messages of errors from stack_valid()
+/// @param [in] errorCode Code of errors
+/// @param [in] filePtr File for writing
+/// @note Also used by dumps of other stacks which share ERROR codes
+void printStackErrors(unsigned errorCode, FILE *filePtr);
+
 #endif
@@ -0,0 +1,31 @@
+#ifndef TIMESTAMP_H_
+#define TIMESTAMP_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// Precisions of timestamps
+enum TIMESTAMP_PRECISION {
+  TIMESTAMP_SECONDS,      // "Sun Oct 18 07:13:23 2026", same as ctime()
+  TIMESTAMP_MICROSECONDS, // "Sun Oct 18 07:13:23.123456 2026"
+};
+
+/// Size of buffer for formatTimestamp()
+const size_t TIMESTAMP_SIZE = 48;
+
+/// Get current time
+/// @param [in] precision Precision from TIMESTAMP_PRECISION
+/// @return Nanoseconds from Epoch
+/// @note Seconds are taken from CLOCK_REALTIME_COARSE, which is read without syscall,
+/// microseconds from CLOCK_REALTIME
+uint64_t getTimestamp(TIMESTAMP_PRECISION precision);
+
+/// Format time as local date
+/// @param [in] time Nanoseconds from Epoch
+/// @param [out] buffer Buffer of TIMESTAMP_SIZE bytes
+/// @param [in] precision Precision from TIMESTAMP_PRECISION
+/// @return Length of C-like string in buffer
+/// @note Date is formatted once per second in each thread, so function is thread-safe and cheap
+size_t formatTimestamp(uint64_t time, char *buffer, TIMESTAMP_PRECISION precision);
+
+#endif
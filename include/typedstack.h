@@ -0,0 +1,707 @@
+/// @brief Header-only typed stack with checks selected at compile time\n
+/// TypedStack<T, Policies...> keeps the behaviour of Stack but:\n
+/// - stores T directly, so moves of elements are inlined;\n
+/// - trivially copyable T is moved with memcpy/realloc,\n
+///   other T is moved with move constructors;\n
+/// - checks are chosen by policies instead of RELEASE_BUILD_/CANARIES_OFF_:\n
+///   CanaryCheck, HashCheck, PoisonCheck, DumpCheck;\n
+/// - array hash is sum of slot hashes of chosen family, so push and pop update it in O(1);\n
+/// - array grows and shrinks by GrowthPolicy as Stack.\n
+/// ElementStack is instantiation for Element with checks from conf.h,
+/// stack_* take their checks and element moves from it.
+///
+#ifndef TYPEDSTACK_H_
+#define TYPEDSTACK_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "stack.h"
+#include "hash.h"
+#include "systemlike.h"
+#include "logging.h"
+#include "elementfunctions.h"
+
+/// Policy: check canaries around stack and its array
+struct CanaryCheck {};
+
+/// Policy: check hashes of stack and its array
+struct HashCheck {};
+
+/// Policy: fill free slots of array with poison
+struct PoisonCheck {};
+
+/// Policy: dump stack into log file when it isn`t valid
+struct DumpCheck {};
+
+/// Policy: no check, it is put instead of check which is turned off
+struct NoCheck {};
+
+/// Choose check or NoCheck at compile time
+template <bool IS_ON, typename Check>
+using CheckIf = typename std::conditional<IS_ON, Check, NoCheck>::type;
+
+/// Element functions for TypedStack
+/// @note Specialize poison(), isPoison() and print() for types used with PoisonCheck or DumpCheck
+template <typename T>
+struct ElementTraits;
+
+template <>
+struct ElementTraits<int>
+{
+  static int poison()                           { return getPoison(nullptr);            }
+  static int isPoison(const int *element)       { return ::isPoison(element);           }
+  static int print(const int *element, FILE *filePtr) { return printElement(element, filePtr); }
+};
+
+template <typename T, typename... Policies>
+class TypedStack final
+{
+public:
+  static constexpr bool HAS_CANARIES = (std::is_same<Policies, CanaryCheck>::value || ...);
+  static constexpr bool HAS_HASH     = (std::is_same<Policies, HashCheck  >::value || ...);
+  static constexpr bool HAS_POISON   = (std::is_same<Policies, PoisonCheck>::value || ...);
+  static constexpr bool HAS_DUMP     = (std::is_same<Policies, DumpCheck  >::value || ...);
+
+  static constexpr bool IS_TRIVIAL   = std::is_trivially_copyable<T>::value;
+
+  static_assert(!HAS_POISON || IS_TRIVIAL, "PoisonCheck needs trivially copyable element");
+
+  TypedStack() = default;
+
+  TypedStack(const TypedStack &)            = delete;
+  TypedStack &operator=(const TypedStack &) = delete;
+
+  ~TypedStack()
+  {
+    if ((status_ & INIT) && !(status_ & DESTROY))
+      destroy();
+  }
+
+  /// Init stack
+  /// @param [in] capacity Start capacity
+  /// @param [in] name Origin name of variable
+  /// @param [in] fileName File name where was create variable
+  /// @param [in] functionName Function name where was create variable
+  /// @param [in] line Line where was create variable
+  /// @param [out] error Return error code
+  void init(size_t capacity, const char *name, const char *fileName, const char *functionName,
+            int line, unsigned *error = nullptr)
+  {
+    if (status_ & INIT)
+      {
+        setError(error, 1);
+
+        return;
+      }
+
+    leftCanary_  = LEFT_CANARY;
+    rightCanary_ = RIGHT_CANARY;
+
+    info_.name         = name;
+    info_.fileName     = fileName;
+    info_.functionName = functionName;
+    info_.line         = line;
+
+    status_ = INIT | EMPTY;
+
+    growth_ = {DEFAULT_STACK_GROWTH, DEFAULT_STACK_SHRINK, DEFAULT_STACK_CAPACITY, 0};
+
+    if (capacity && !reallocate(capacity))
+      {
+        setError(error, 1);
+
+        return;
+      }
+
+    updateHash();
+
+    check(error);
+  }
+
+  /// Destroy stack
+  /// @param [out] error Return error code
+  void destroy(unsigned *error = nullptr)
+  {
+    if (!check(error))
+      return;
+
+    for (size_t i = 0; i < size_; ++i)
+      array_[i].~T();
+
+    if (array_)
+      free(rawBlock());
+
+    array_    = nullptr;
+    capacity_ = 0;
+    size_     = 0;
+    status_  |= DESTROY;
+
+    updateHash();
+  }
+
+  /// Push copy of element
+  /// @param [in] element Element to push
+  /// @param [out] error Return error code
+  void push(const T &element, unsigned *error = nullptr)
+  {
+    if (!check(error) || !reserveOne(error))
+      return;
+
+    beginSlotUpdate(size_);
+
+    new (&array_[size_++]) T(element);
+
+    status_ &= NOT_EMPTY;
+
+    endSlotUpdate(size_ - 1);
+
+    check(error);
+  }
+
+  /// Push element by moving it
+  /// @param [in] element Element to push
+  /// @param [out] error Return error code
+  void push(T &&element, unsigned *error = nullptr)
+  {
+    if (!check(error) || !reserveOne(error))
+      return;
+
+    beginSlotUpdate(size_);
+
+    new (&array_[size_++]) T(std::move(element));
+
+    status_ &= NOT_EMPTY;
+
+    endSlotUpdate(size_ - 1);
+
+    check(error);
+  }
+
+  /// Pop element
+  /// @param [out] element Container for pop-element
+  /// @param [out] error Return error code
+  void pop(T *element, unsigned *error = nullptr)
+  {
+    if (!check(error))
+      return;
+
+    if (!element || !size_)
+      {
+        setError(error, 1);
+
+        return;
+      }
+
+    beginSlotUpdate(size_ - 1);
+
+    *element = std::move(array_[--size_]);
+
+    array_[size_].~T();
+
+    if constexpr (HAS_POISON)
+      array_[size_] = ElementTraits<T>::poison();
+
+    if (!size_)
+      status_ |= EMPTY;
+
+    endSlotUpdate(size_);
+
+    size_t newCapacity = shrinkCapacity();
+
+    if (newCapacity < capacity_ && !reallocate(newCapacity))
+      {
+        setError(error, 1);
+
+        return;
+      }
+
+    check(error);
+  }
+
+  /// Size of stack
+  size_t size()     const { return size_;     }
+
+  /// Size of stack`s array
+  size_t capacity() const { return capacity_; }
+
+  /// Check that stack is empty
+  int isEmpty()     const { return status_ & EMPTY; }
+
+  /// Set policy of growth and shrink
+  /// @param [in] policy Pointer to policy, zero fields mean default values
+  /// @param [out] error Return error code
+  /// @note Policy is checked as in stack_setGrowthPolicy()
+  void setGrowthPolicy(const GrowthPolicy *policy, unsigned *error = nullptr)
+  {
+    if (!check(error))
+      return;
+
+    if (!policy)
+      {
+        setError(error, 1);
+
+        return;
+      }
+
+    GrowthPolicy growth = *policy;
+
+    if (!growth.growthFactor)
+      growth.growthFactor  = DEFAULT_STACK_GROWTH;
+
+    if (!growth.shrinkDivider)
+      growth.shrinkDivider = DEFAULT_STACK_SHRINK;
+
+    if (!growth.minCapacity)
+      growth.minCapacity   = DEFAULT_STACK_CAPACITY;
+
+    if (growth.growthFactor < 2 || growth.shrinkDivider <= growth.growthFactor)
+      {
+        setError(error, 1);
+
+        return;
+      }
+
+    growth_ = growth;
+
+    updateStructHash();
+
+    check(error);
+  }
+
+  /// Set family of hash function
+  /// @param [in] family Family of hash function
+  /// @param [out] error Return error code
+  /// @note Stack and array are rehashed at once
+  void setHashFamily(HASH_FAMILY family, unsigned *error = nullptr)
+  {
+    if (!check(error))
+      return;
+
+    if (family != HASH_DJB && family != HASH_CRC32C && family != HASH_XXH32)
+      {
+        setError(error, 1);
+
+        return;
+      }
+
+    hashFamily_ = family;
+
+    updateHash();
+
+    check(error);
+  }
+
+  /// Check valid of stack
+  /// @return Code of error like stack_valid()
+  unsigned valid() const
+  {
+    unsigned error = 0;
+
+    if (!(status_ & INIT) && (status_ & DESTROY))
+      error |= DESTROY_WITHOUT_INIT;
+
+    if (!array_ && capacity_)
+      error |= NULL_ARRAY_POINTER;
+
+    if (capacity_ < size_)
+      error |= CAPACITY_LESS_THAN_SIZE;
+
+    if constexpr (HAS_CANARIES)
+      {
+        if (leftCanary_ != LEFT_CANARY)
+          error |= LEFT_CANARY_DIED;
+
+        if (rightCanary_ != RIGHT_CANARY)
+          error |= RIGHT_CANARY_DIED;
+
+        if (array_ && readCanary(rawBlock()) != LEFT_ARRAY_CANARY)
+          error |= LEFT_ARRAY_CANARY_DIED;
+
+        if (array_ && readCanary(array_ + capacity_) != RIGHT_ARRAY_CANARY)
+          error |= RIGHT_ARRAY_CANARY_DIED;
+      }
+
+    if constexpr (HAS_HASH)
+      {
+        if (array_ && arrayHash() != arrayHash_)
+          error |= DIFFERENT_ARRAY_HASH;
+
+        if (structHash() != hash_)
+          error |= DIFFERENT_HASH;
+      }
+
+    if (!isPointerCorrect(info_.name))
+      error |= NOT_NAME;
+
+    if (!isPointerCorrect(info_.fileName))
+      error |= NOT_FILE_NAME;
+
+    if (!isPointerCorrect(info_.functionName))
+      error |= NOT_FUNCTION_NAME;
+
+    if (info_.line <= 0)
+      error |= INCORRECT_LINE;
+
+    return error;
+  }
+
+  /// Dump stack into file
+  /// @param [in] errorCode Code from valid()
+  /// @param [in] filePtr File for writing
+  void dump(unsigned errorCode, FILE *filePtr) const
+  {
+    if (!isPointerCorrect(filePtr))
+      filePtr = stdout;
+
+    fprintf(filePtr, "\nTypedStack[%p] \"%s\" at %s at %s (%d)\n",
+            (const void *)this,
+            isPointerCorrect(info_.name)         ? info_.name         : "nullptr",
+            isPointerCorrect(info_.functionName) ? info_.functionName : "nullptr",
+            isPointerCorrect(info_.fileName)     ? info_.fileName     : "nullptr",
+            info_.line);
+
+    fprintf(filePtr, "Error code: %u Capacity: %lu Size: %lu\n", errorCode, capacity_, size_);
+
+    if constexpr (HAS_DUMP)
+      for (size_t i = 0; i < capacity_ && array_; ++i)
+        {
+          fputc('|', filePtr);
+
+          if (i < size_)
+            ElementTraits<T>::print(&array_[i], filePtr);
+          else if (isFreeSlotPoison(i))
+            fprintf(filePtr, "POISON");
+          else
+            ElementTraits<T>::print(&array_[i], filePtr);
+        }
+
+    fprintf(filePtr, "|\n");
+  }
+
+  /// Copy elements into slots
+  /// @param [out] target Pointer to first slot
+  /// @param [in] source Pointer to first element
+  /// @param [in] count Count of elements
+  /// @note Trivially copyable elements are copied with one memcpy, other are assigned
+  static void copySlots(T *target, const T *source, size_t count)
+  {
+    if constexpr (IS_TRIVIAL)
+      memcpy((void *)target, (const void *)source, count * sizeof(T));
+    else
+      for (size_t i = 0; i < count; ++i)
+        target[i] = source[i];
+  }
+
+  /// Move elements into raw memory and destroy them in old place
+  /// @param [out] target Pointer to first slot of raw memory
+  /// @param [in/out] source Pointer to first element
+  /// @param [in] count Count of elements
+  static void moveSlots(T *target, T *source, size_t count)
+  {
+    if constexpr (IS_TRIVIAL)
+      memcpy((void *)target, (const void *)source, count * sizeof(T));
+    else
+      for (size_t i = 0; i < count; ++i)
+        {
+          new (&target[i]) T(std::move(source[i]));
+
+          source[i].~T();
+        }
+  }
+
+  /// Fill slots with poison
+  /// @param [out] slots Pointer to first slot
+  /// @param [in] count Count of slots
+  /// @note Trivially copyable poison is written once and then copied by doubling memcpy,
+  /// other poison is assigned to each slot, so slots must hold objects
+  static void fillPoison(T *slots, size_t count)
+  {
+    if (!count)
+      return;
+
+    slots[0] = ElementTraits<T>::poison();
+
+    if constexpr (IS_TRIVIAL)
+      for (size_t filled = 1; filled < count; filled *= 2)
+        memcpy((void *)&slots[filled], (const void *)&slots[0],
+               (filled < count - filled ? filled : count - filled) * sizeof(T));
+    else
+      for (size_t i = 1; i < count; ++i)
+        slots[i] = slots[0];
+  }
+
+  /// Check that slot holds poison
+  /// @param [in] slot Pointer to slot
+  /// @return Is slot poison
+  static bool isPoisonSlot(const T *slot)
+  {
+    return ElementTraits<T>::isPoison(slot);
+  }
+
+private:
+  static constexpr size_t HEADER_SIZE  = HAS_CANARIES ?
+    (alignof(T) > sizeof(CANARY) ? alignof(T) : sizeof(CANARY)) : 0;
+  static constexpr size_t TRAILER_SIZE = HAS_CANARIES ? sizeof(CANARY) : 0;
+
+  CANARY leftCanary_ = 0;
+
+  T     *array_    = nullptr;
+  size_t capacity_ = 0;
+  size_t size_     = 0;
+
+  unsigned status_ = 0;
+
+  DebugInfo info_ = {};
+
+  GrowthPolicy growth_ = {};
+
+  HASH_FAMILY hashFamily_ = HASH_CRC32C;
+
+  unsigned hash_      = 0;
+  unsigned arrayHash_ = 0;
+
+  CANARY rightCanary_ = 0;
+
+  static void setError(unsigned *error, unsigned code)
+  {
+    if (error)
+      *error = code;
+  }
+
+  static CANARY readCanary(const void *pointer)
+  {
+    CANARY canary = 0;
+
+    memcpy(&canary, pointer, sizeof(CANARY));
+
+    return canary;
+  }
+
+  static void writeCanary(void *pointer, CANARY canary)
+  {
+    memcpy(pointer, &canary, sizeof(CANARY));
+  }
+
+  /// Check free slot for dump
+  /// @note Without PoisonCheck free slots hold no objects and are always shown as poison
+  bool isFreeSlotPoison(size_t index) const
+  {
+    if constexpr (HAS_POISON)
+      return ElementTraits<T>::isPoison(&array_[index]);
+    else
+      return true;
+  }
+
+  char *rawBlock() const
+  {
+    return (char *)array_ - HEADER_SIZE;
+  }
+
+  /// Check stack and dump it if it is incorrect
+  /// @param [out] error Return error code
+  /// @return Is stack correct
+  bool check(unsigned *error) const
+  {
+    if constexpr (!HAS_CANARIES && !HAS_HASH && !HAS_DUMP)
+      return true;
+
+    unsigned errorCode = valid();
+
+    if (!errorCode)
+      return true;
+
+    if constexpr (HAS_DUMP)
+      dump(errorCode, getLogFile());
+
+    setError(error, errorCode);
+
+    return false;
+  }
+
+  /// Hash of stack with zero in place of hash_
+  /// @note Stack is copied, so check doesn`t write into stack
+  unsigned structHash() const
+  {
+    unsigned char copy[sizeof(TypedStack)] = {};
+
+    memcpy(copy, (const void *)this, sizeof(TypedStack));
+
+    memset(copy + offsetof(TypedStack, hash_), 0, sizeof(hash_));
+
+    return getFamilyHash(copy, sizeof(TypedStack), hashFamily_);
+  }
+
+  /// Position-weighted hash of whole array
+  unsigned arrayHash() const
+  {
+    return array_ ? getArrayHash(array_, capacity_, sizeof(T), hashFamily_) : 0;
+  }
+
+  void updateStructHash()
+  {
+    if constexpr (HAS_HASH)
+      hash_ = structHash();
+  }
+
+  void updateHash()
+  {
+    if constexpr (HAS_HASH)
+      {
+        arrayHash_ = arrayHash();
+
+        updateStructHash();
+      }
+  }
+
+  /// Remove hash of slot from array hash before slot is changed
+  void beginSlotUpdate(size_t index)
+  {
+    if constexpr (HAS_HASH)
+      arrayHash_ -= getSlotHash(&array_[index], sizeof(T), index, hashFamily_);
+  }
+
+  /// Add hash of changed slot to array hash and rehash stack
+  void endSlotUpdate(size_t index)
+  {
+    if constexpr (HAS_HASH)
+      {
+        arrayHash_ += getSlotHash(&array_[index], sizeof(T), index, hashFamily_);
+
+        updateStructHash();
+      }
+  }
+
+  bool reserveOne(unsigned *error)
+  {
+    if (size_ < capacity_)
+      return true;
+
+    size_t newCapacity = capacity_ ? capacity_ * growth_.growthFactor : growth_.minCapacity;
+
+    if (reallocate(newCapacity))
+      return true;
+
+    setError(error, 1);
+
+    return false;
+  }
+
+  /// Get capacity after auto-shrink, same rule as shrinkCapacity() of Stack
+  size_t shrinkCapacity() const
+  {
+    if (growth_.neverShrink || size_ * growth_.shrinkDivider > capacity_)
+      return capacity_;
+
+    size_t newCapacity = capacity_ / growth_.growthFactor;
+
+    if (newCapacity < growth_.minCapacity)
+      newCapacity = growth_.minCapacity;
+
+    if (newCapacity < size_)
+      newCapacity = size_;
+
+    return newCapacity < capacity_ ? newCapacity : capacity_;
+  }
+
+  /// Move array into block with newCapacity elements
+  /// @param [in] newCapacity New capacity of array
+  /// @return Was array moved
+  bool reallocate(size_t newCapacity)
+  {
+    size_t blockSize = HEADER_SIZE + newCapacity * sizeof(T) + TRAILER_SIZE;
+
+    char *block = nullptr;
+
+    if constexpr (IS_TRIVIAL)
+      {
+        block = (char *) realloc(array_ ? rawBlock() : nullptr, blockSize);
+
+        if (!block)
+          return false;
+      }
+    else
+      {
+        block = (char *) calloc(1, blockSize);
+
+        if (!block)
+          return false;
+
+        moveSlots((T *)(block + HEADER_SIZE), array_, size_);
+
+        if (array_)
+          free(rawBlock());
+      }
+
+    array_ = (T *)(block + HEADER_SIZE);
+
+    if constexpr (HAS_POISON)
+      {
+        if (newCapacity > capacity_)
+          fillPoison(array_ + capacity_, newCapacity - capacity_);
+      }
+    else if constexpr (IS_TRIVIAL)
+      if (newCapacity > capacity_)
+        memset((void *)(array_ + capacity_), 0, (newCapacity - capacity_) * sizeof(T));
+
+    if constexpr (HAS_CANARIES)
+      {
+        writeCanary(block, LEFT_ARRAY_CANARY);
+
+        writeCanary(array_ + newCapacity, RIGHT_ARRAY_CANARY);
+      }
+
+    capacity_ = newCapacity;
+
+    updateHash();
+
+    return true;
+  }
+};
+
+#define typedstack_init(stk, capacity)          \
+  (stk)->init(capacity, INIT_INFO(stk))
+
+#if !defined(RELEASE_BUILD_) && !defined(CANARIES_OFF_)
+
+const bool STACK_CANARIES = true;
+
+#else
+
+const bool STACK_CANARIES = false;
+
+#endif
+
+#if !defined(RELEASE_BUILD_) && !defined(HASH_OFF_)
+
+const bool STACK_HASH = true;
+
+#else
+
+const bool STACK_HASH = false;
+
+#endif
+
+#if !defined(RELEASE_BUILD_) && !defined(STACK_DUMP_OFF_)
+
+const bool STACK_DUMP = true;
+
+#else
+
+const bool STACK_DUMP = false;
+
+#endif
+
+/// Typed stack of Element with checks of Stack from conf.h
+/// @note Poison is checked only for trivially copyable Element, other Element is copied by copyFunction
+typedef TypedStack<Element,
+                   CheckIf<STACK_CANARIES, CanaryCheck>,
+                   CheckIf<STACK_HASH,     HashCheck  >,
+                   CheckIf<std::is_trivially_copyable<Element>::value, PoisonCheck>,
+                   CheckIf<STACK_DUMP,     DumpCheck  >> ElementStack;
+
+#endif
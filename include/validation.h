@@ -0,0 +1,127 @@
+#ifndef VALIDATION_H_
+#define VALIDATION_H_
+
+#include <stdint.h>
+#include "stack.h"
+
+/// Policies of validation scheduler
+enum VALIDATION_MODE {
+  VALIDATE_ALWAYS,     // Check stack on every call, as before
+  VALIDATE_EVERY_NTH,  // Check every period-th call in each thread
+  VALIDATE_RANDOM,     // Check call with chance 1/period
+  VALIDATE_ON_RESIZE,  // Check only calls which change array (init, resize, destroy)
+  VALIDATE_BACKGROUND, // Don`t check calls of registered stacks, background thread checks them
+};
+
+/// Kinds of places where stack can be checked
+enum VALIDATION_POINT {
+  VALIDATION_OPERATION, // Push, pop and other calls
+  VALIDATION_RESIZE,    // Calls which change array
+};
+
+/// Settings of validation scheduler
+/// @note Zero fields mean default values
+typedef struct {
+  VALIDATION_MODE mode;
+  unsigned period;      // N for VALIDATE_EVERY_NTH and VALIDATE_RANDOM
+  unsigned intervalMs;  // Pause between passes of background thread
+} ValidationPolicy;
+
+/// Counters of validation scheduler
+/// @note Each thread adds its requests, validations and time by batches,
+/// so counters of other threads can be behind by one batch
+typedef struct {
+  uint64_t requests;    // Calls which could be checked
+  uint64_t validations; // Calls of stack_valid() made by scheduler
+  uint64_t failures;    // Validations which found errors
+  uint64_t busySkips;   // Background checks dropped, because stack was changed during check
+  uint64_t nanoseconds; // Time spent in stack_valid()
+} ValidationStats;
+
+/// Count of stacks which can be checked by background thread at once
+const int VALIDATION_REGISTRY_SIZE = 64;
+
+/// Set policy of validation for all stacks
+/// @param [in] policy Pointer to new policy
+/// @param [out] error Return error code
+/// @note Starts or stops background thread if it is need
+void validation_setPolicy(const ValidationPolicy *policy, unsigned *error = nullptr);
+
+/// Get current policy of validation
+/// @param [out] policy Container for policy
+void validation_getPolicy(ValidationPolicy *policy);
+
+/// Get counters of validation scheduler
+/// @param [out] stats Container for counters
+void validation_stats(ValidationStats *stats);
+
+/// Reset counters of validation scheduler
+void validation_resetStats();
+
+/// Decide that call must be checked
+/// @param [in] point Kind of call
+/// @param [in] stk Pointer to stack
+/// @return 1 if stack must be checked or 0 if it must not
+/// @note In VALIDATE_BACKGROUND mode stacks which aren`t in list of background thread
+/// (made before mode was set or when list was full) are checked on every call
+int validation_shouldCheck(VALIDATION_POINT point, const Stack *stk);
+
+/// Check stack and update counters
+/// @param [in] stk Pointer to stack
+/// @return Code of error from stack_valid()
+unsigned validation_check(const Stack *stk);
+
+/// Mark that background thread uses list of stacks
+/// @note Stacks are added to list only between this call and validation_releaseRegistry()
+void validation_retainRegistry();
+
+/// Mark that background thread doesn`t use list of stacks any more
+/// @note List is cleared when last user releases it
+void validation_releaseRegistry();
+
+/// Add stack to list of background thread
+/// @param [in] stk Pointer to stack
+/// @return Slot of stack or -1 if list is full or isn`t used now
+/// @note Slot is returned in write state, call validation_endWrite() when stack is ready.\n
+/// Full list is written to log as error
+int validation_register(const Stack *stk);
+
+/// Remove stack from list of background thread
+/// @param [in] stk Pointer to stack
+/// @note Does nothing if stack isn`t in list. Waits for end of check of this stack
+void validation_unregister(const Stack *stk);
+
+/// Lock registered stack for reading from other thread
+/// @param [in] slot Slot of stack
+/// @param [out] version Version of stack at moment of lock
+/// @return Pointer to stack or nullptr if slot is free or stack is being changed now
+/// @note Array isn`t freed while lock is held, but other fields can be changed.\n
+/// Read result is correct only if validation_isUnchanged() returns 1 after read.\n
+/// Call validation_unlockStack() in both cases
+const Stack *validation_lockStack(int slot, unsigned *version);
+
+/// Check that stack wasn`t changed after validation_lockStack()
+/// @param [in] slot Slot of stack
+/// @param [in] version Version from validation_lockStack()
+/// @return 1 if stack wasn`t changed or 0 if it was
+int validation_isUnchanged(int slot, unsigned version);
+
+/// Unlock stack after validation_lockStack()
+/// @param [in] slot Slot of stack
+void validation_unlockStack(int slot);
+
+/// Mark start of change of stack
+/// @param [in] slot Slot of stack
+/// @param [in] stk Pointer to stack
+/// @param [in] lock 1 if array will be reallocated or freed
+/// @return 1 if change is marked or 0 if stack isn`t in this slot
+/// @note Calls can be nested. Background thread skips stack until validation_endWrite().\n
+/// Call validation_endWrite() only if 1 is returned
+int validation_beginWrite(int slot, const Stack *stk, int lock);
+
+/// Mark end of change of stack
+/// @param [in] slot Slot of stack
+/// @param [in] lock Same value as in validation_beginWrite()
+void validation_endWrite(int slot, int lock);
+
+#endif
@@ -0,0 +1,130 @@
+#ifndef WORKDEQUE_H_
+#define WORKDEQUE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <atomic>
+#include "stack.h"
+
+/// Circular array of WorkDeque
+/// @note Old arrays are kept in list of previous arrays while thieves can read them,
+/// owner frees them at next push when no thief works
+typedef struct DequeArray {
+  size_t capacity;
+
+  std::atomic<Element> *elements;
+
+  struct DequeArray *previous;
+} DequeArray;
+
+/// Chase-Lev work-stealing deque
+/// @note Owner thread pushes and pops at bottom like stack_push/stack_pop,
+/// other threads steal from top without locks
+typedef struct {
+#ifndef RELEASE_BUILD_
+
+  CANARY leftCanary;
+
+#endif
+
+  std::atomic<int64_t> top;
+  std::atomic<int64_t> bottom;
+
+  std::atomic<DequeArray *>   array;
+  mutable std::atomic<size_t> thieves; // Threads except owner which can read array now
+
+  unsigned status;
+
+#ifndef RELEASE_BUILD_
+
+  DebugInfo info;
+
+  CANARY rightCanary;
+
+#endif
+} WorkDeque;
+
+/// Results of workdeque_steal()
+enum STEAL_RESULT {
+  STEAL_SUCCESS,
+  STEAL_EMPTY  ,
+  STEAL_ABORT  , // Other thread took same element, try again
+};
+
+/// Chech valid of deque
+/// @param [in] dq Pointer to deque
+/// @return Code of error from ERROR
+unsigned workdeque_valid(const WorkDeque *dq);
+
+#define workdeque_init(dq, capacity)                    \
+  do_workdeque_init(dq, capacity, INIT_INFO(dq))
+
+/// Init deque
+/// @param [in/out] dq Pointer to deque for init
+/// @param [in] capacity Start capacity, rounded up to power of two
+/// @param [in] name Origin name of variable
+/// @param [in] fileName File name where was create variable
+/// @param [in] functionName Function name where was create variable
+/// @param [in] line Line where was create variable
+/// @param [out] error Return error code
+void do_workdeque_init(WorkDeque *dq, size_t capacity,
+                       const char *name, const char *fileName, const char *functionName, int line,
+                       unsigned *error = nullptr);
+
+/// Destroy deque
+/// @param [in] dq Pointer to deque
+/// @param [out] error Return error code
+/// @note Call after all threads stop using deque
+void workdeque_destroy(WorkDeque *dq, unsigned *error = nullptr);
+
+/// Push element at bottom
+/// @param [in/out] dq Pointer to deque
+/// @param [in] element Pointer to element to push
+/// @param [out] error Return error code
+/// @note Call only from owner thread
+void workdeque_push(WorkDeque *dq, const Element *element, unsigned *error = nullptr);
+
+/// Pop element from bottom
+/// @param [in/out] dq Pointer to deque
+/// @param [out] element Container for pop-element
+/// @param [out] error Return error code
+/// @note Call only from owner thread. If deque is empty set error to 1
+void workdeque_pop(WorkDeque *dq, Element *element, unsigned *error = nullptr);
+
+/// Steal element from top
+/// @param [in/out] dq Pointer to deque
+/// @param [out] element Container for stolen element
+/// @param [out] error Return error code
+/// @return Result from STEAL_RESULT
+/// @note Can be called from any thread
+int workdeque_steal(WorkDeque *dq, Element *element, unsigned *error = nullptr);
+
+/// Size of deque
+/// @param [in] dq Pointer to deque
+/// @param [out] error Return error code
+/// @return Count of elements at moment of call
+size_t workdeque_size(const WorkDeque *dq, unsigned *error = nullptr);
+
+#ifndef RELEASE_BUILD_
+
+#define workdeque_dump(dq, errorCode, filePtr)          \
+  do_workdeque_dump(dq, errorCode, filePtr, LINE_INFO)
+
+#else
+
+#define workdeque_dump(dq, errorCode, filePtr) ;
+
+#endif
+
+/// Dump deque into file
+/// @param [in] dq Pointer to deque for dump
+/// @param [in] errorCode Code from workdeque_valid()
+/// @param [in] filePtr File for logging
+/// @param [in] fileName Name of file where was call function
+/// @param [in] functionName Name of function where was call function
+/// @param [in] line Line where was call function
+/// @note Elements are exact only if thieves don`t work at moment of dump
+void do_workdeque_dump(const WorkDeque *dq, unsigned errorCode, FILE *filePtr,
+                       const char *fileName, const char *functionName, int line);
+
+#endif
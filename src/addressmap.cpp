@@ -0,0 +1,461 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/uio.h>
+#include "addressmap.h"
+
+/// Kinds of ranges of map, they show if range can disappear without addressmap`s knowledge
+enum RANGE_KIND {
+  RANGE_FILE     , // Mapping of file or special mapping like [stack], it lives while program runs
+  RANGE_HEAP     , // [heap], its end moves with brk()
+  RANGE_ANONYMOUS, // Anonymous mapping, malloc() and other libraries can unmap it
+};
+
+typedef struct {
+  size_t begin;
+  size_t end;
+
+  RANGE_KIND kind;
+} AddressRange;
+
+const size_t MAPS_READ_BLOCK      = 4096;
+const size_t DEFAULT_RANGES_COUNT = 64;
+
+static pthread_rwlock_t MAP_LOCK = PTHREAD_RWLOCK_INITIALIZER;
+
+static AddressRange *RANGES          = nullptr;
+static size_t        RANGES_COUNT    = 0;
+static size_t        RANGES_CAPACITY = 0;
+static int           IS_MAP_LOADED   = 0;
+
+static pthread_once_t PID_ONCE = PTHREAD_ONCE_INIT;
+static pid_t          SELF_PID = 0;
+
+// Known ranges are sorted by begin and don`t overlap, as ranges of map
+static AddressRange *KNOWN_RANGES   = nullptr;
+static size_t        KNOWN_COUNT    = 0;
+static size_t        KNOWN_CAPACITY = 0;
+
+/// Read all /proc/self/maps into heap
+/// @param [out] size Size of read text
+/// @return C-like string in heap or nullptr if was error
+static char *readMaps(size_t *size);
+
+/// Add readable range into RANGES merging it with previous
+/// @param [in] begin Begin of range
+/// @param [in] end End of range
+/// @param [in] kind Kind of range
+/// @return Was range added
+static int pushRange(size_t begin, size_t end, RANGE_KIND kind);
+
+/// Get kind of range by line of /proc/self/maps
+/// @param [in] fields Fields of line after addresses: permissions, offset, device, inode and path
+/// @return Kind of range
+static RANGE_KIND rangeKind(const char *fields);
+
+/// Check that address of range which can disappear is still readable
+/// @param [in] address Address for check
+/// @param [in] kind Kind of range where address was found in cached map
+/// @return 1 if address is readable, 0 if is not and -1 if it can`t be checked without new map
+static int isStillReadable(size_t address, RANGE_KIND kind);
+
+/// Remember id of process and update it in child after fork()
+static void initPid();
+
+/// Remember id of process
+static void rememberPid();
+
+/// Search address in sorted ranges by binary search
+/// @param [in] ranges Array of ranges sorted by begin
+/// @param [in] count Count of ranges
+/// @param [in] address Address for search
+/// @return Index of range with address or index where range with address can be put
+/// @note Call under MAP_LOCK
+static size_t findRange(const AddressRange *ranges, size_t count, size_t address);
+
+/// Check that address is in one of sorted ranges
+/// @param [in] ranges Array of ranges sorted by begin
+/// @param [in] count Count of ranges
+/// @param [in] address Address for search
+/// @return Is address in one of ranges
+/// @note Call under MAP_LOCK
+static int isInRanges(const AddressRange *ranges, size_t count, size_t address);
+
+/// Make place for count ranges in KNOWN_RANGES
+/// @param [in] count Count of ranges
+/// @return Is place made
+/// @note Call under MAP_LOCK for writing
+static int reserveKnownRanges(size_t count);
+
+int isAddressMapped(const void *pointer)
+{
+  size_t address = (size_t)pointer;
+
+  pthread_rwlock_rdlock(&MAP_LOCK);
+
+  int isFound  = isInRanges(KNOWN_RANGES, KNOWN_COUNT, address);
+  int isCached = 0;
+
+  RANGE_KIND kind = RANGE_FILE;
+
+  if (!isFound && IS_MAP_LOADED)
+    {
+      size_t index = findRange(RANGES, RANGES_COUNT, address);
+
+      isCached = index < RANGES_COUNT && RANGES[index].begin <= address && address < RANGES[index].end;
+
+      if (isCached)
+        kind = RANGES[index].kind;
+    }
+
+  pthread_rwlock_unlock(&MAP_LOCK);
+
+  if (isFound)
+    return 1;
+
+  // Cached map can be old, so range which can disappear is checked again
+  if (isCached)
+    {
+      int isReadable = isStillReadable(address, kind);
+
+      if (isReadable != -1)
+        return isReadable;
+    }
+
+  if (!refreshAddressMap())
+    return -1;
+
+  pthread_rwlock_rdlock(&MAP_LOCK);
+
+  isFound = isInRanges(RANGES, RANGES_COUNT, address);
+
+  pthread_rwlock_unlock(&MAP_LOCK);
+
+  return isFound;
+}
+
+int refreshAddressMap()
+{
+  size_t size = 0;
+
+  char *maps = readMaps(&size);
+
+  if (!maps)
+    return 0;
+
+  pthread_rwlock_wrlock(&MAP_LOCK);
+
+  RANGES_COUNT = 0;
+
+  int isCorrect = 1;
+
+  for (char *line = maps; line < maps + size && *line; )
+    {
+      char *next = strchr(line, '\n');
+
+      if (next)
+        *next = '\0';
+
+      char *current = line;
+
+      size_t begin = (size_t)strtoull(current, &current, 16);
+
+      if (*current == '-')
+        {
+          size_t end = (size_t)strtoull(current + 1, &current, 16);
+
+          if (*current == ' ' && current[1] == 'r' && !pushRange(begin, end, rangeKind(current + 1)))
+            {
+              isCorrect = 0;
+
+              break;
+            }
+        }
+
+      if (!next)
+        break;
+
+      line = next + 1;
+    }
+
+  IS_MAP_LOADED = isCorrect;
+
+  pthread_rwlock_unlock(&MAP_LOCK);
+
+  free(maps);
+
+  return isCorrect;
+}
+
+int addKnownRange(const void *begin, size_t size)
+{
+  if (!begin || !size)
+    return 0;
+
+  pthread_rwlock_wrlock(&MAP_LOCK);
+
+  int isAdded = reserveKnownRanges(KNOWN_COUNT + 1);
+
+  if (isAdded)
+    {
+      size_t index = findRange(KNOWN_RANGES, KNOWN_COUNT, (size_t)begin);
+
+      memmove(KNOWN_RANGES + index + 1, KNOWN_RANGES + index, (KNOWN_COUNT - index) * sizeof(AddressRange));
+
+      KNOWN_RANGES[index].begin = (size_t)begin;
+      KNOWN_RANGES[index].end   = (size_t)begin + size;
+      KNOWN_RANGES[index].kind  = RANGE_FILE;
+
+      ++KNOWN_COUNT;
+    }
+
+  pthread_rwlock_unlock(&MAP_LOCK);
+
+  return isAdded;
+}
+
+void removeKnownRange(const void *begin)
+{
+  if (!begin)
+    return;
+
+  pthread_rwlock_wrlock(&MAP_LOCK);
+
+  size_t index = findRange(KNOWN_RANGES, KNOWN_COUNT, (size_t)begin);
+
+  if (index < KNOWN_COUNT && KNOWN_RANGES[index].begin == (size_t)begin)
+    {
+      memmove(KNOWN_RANGES + index, KNOWN_RANGES + index + 1, (KNOWN_COUNT - index - 1) * sizeof(AddressRange));
+
+      --KNOWN_COUNT;
+    }
+
+  pthread_rwlock_unlock(&MAP_LOCK);
+}
+
+void forgetAddressRange(const void *begin, size_t size)
+{
+  if (!begin || !size)
+    return;
+
+  size_t first = (size_t)begin;
+  size_t last  = first + size;
+
+  pthread_rwlock_wrlock(&MAP_LOCK);
+
+  // Ranges of stacks which weren`t destroyed can be inside of released memory
+  size_t kept = 0;
+
+  for (size_t i = 0; i < KNOWN_COUNT; ++i)
+    if (KNOWN_RANGES[i].end <= first || last <= KNOWN_RANGES[i].begin)
+      KNOWN_RANGES[kept++] = KNOWN_RANGES[i];
+
+  KNOWN_COUNT = kept;
+
+  size_t index = findRange(RANGES, RANGES_COUNT, first);
+
+  if (index < RANGES_COUNT && RANGES[index].begin < last)
+    IS_MAP_LOADED = 0;
+
+  pthread_rwlock_unlock(&MAP_LOCK);
+}
+
+static char *readMaps(size_t *size)
+{
+  int fd = open("/proc/self/maps", O_RDONLY);
+
+  if (fd == -1)
+    return nullptr;
+
+  size_t capacity = MAPS_READ_BLOCK;
+  size_t length   = 0;
+
+  char *text = (char *) malloc(capacity + 1);
+
+  while (text)
+    {
+      if (length == capacity)
+        {
+          char *temp = (char *) realloc(text, 2 * capacity + 1);
+
+          if (!temp)
+            {
+              free(text);
+
+              text = nullptr;
+
+              break;
+            }
+
+          text      = temp;
+          capacity *= 2;
+        }
+
+      ssize_t count = read(fd, text + length, capacity - length);
+
+      if (count < 0)
+        {
+          free(text);
+
+          text = nullptr;
+        }
+      else if (count == 0)
+        break;
+      else
+        length += (size_t)count;
+    }
+
+  close(fd);
+
+  if (!text)
+    return nullptr;
+
+  text[length] = '\0';
+
+  *size = length;
+
+  return text;
+}
+
+static int pushRange(size_t begin, size_t end, RANGE_KIND kind)
+{
+  if (RANGES_COUNT && RANGES[RANGES_COUNT - 1].end == begin && RANGES[RANGES_COUNT - 1].kind == kind)
+    {
+      RANGES[RANGES_COUNT - 1].end = end;
+
+      return 1;
+    }
+
+  if (RANGES_COUNT == RANGES_CAPACITY)
+    {
+      size_t newCapacity = RANGES_CAPACITY ? 2 * RANGES_CAPACITY : DEFAULT_RANGES_COUNT;
+
+      AddressRange *temp = (AddressRange *) realloc(RANGES, newCapacity * sizeof(AddressRange));
+
+      if (!temp)
+        return 0;
+
+      RANGES          = temp;
+      RANGES_CAPACITY = newCapacity;
+    }
+
+  RANGES[RANGES_COUNT].begin = begin;
+  RANGES[RANGES_COUNT].end   = end;
+  RANGES[RANGES_COUNT].kind  = kind;
+
+  ++RANGES_COUNT;
+
+  return 1;
+}
+
+static size_t findRange(const AddressRange *ranges, size_t count, size_t address)
+{
+  size_t left  = 0;
+  size_t right = count;
+
+  while (left < right)
+    {
+      size_t middle = left + (right - left) / 2;
+
+      if (address < ranges[middle].begin)
+        right = middle;
+      else if (address >= ranges[middle].end)
+        left  = middle + 1;
+      else
+        return middle;
+    }
+
+  return left;
+}
+
+static int isInRanges(const AddressRange *ranges, size_t count, size_t address)
+{
+  size_t index = findRange(ranges, count, address);
+
+  return index < count && ranges[index].begin <= address && address < ranges[index].end;
+}
+
+static int reserveKnownRanges(size_t count)
+{
+  if (count <= KNOWN_CAPACITY)
+    return 1;
+
+  size_t newCapacity = KNOWN_CAPACITY ? 2 * KNOWN_CAPACITY : DEFAULT_RANGES_COUNT;
+
+  AddressRange *temp = (AddressRange *) realloc(KNOWN_RANGES, newCapacity * sizeof(AddressRange));
+
+  if (!temp)
+    return 0;
+
+  KNOWN_RANGES   = temp;
+  KNOWN_CAPACITY = newCapacity;
+
+  return 1;
+}
+
+static RANGE_KIND rangeKind(const char *fields)
+{
+  // Path is fifth field after addresses
+  for (int i = 0; i < 4 && fields; ++i)
+    {
+      fields = strchr(fields, ' ');
+
+      if (fields)
+        fields += strspn(fields, " ");
+    }
+
+  if (!fields || !*fields)
+    return RANGE_ANONYMOUS;
+
+  if (!strncmp(fields, "[heap]", sizeof("[heap]") - 1))
+    return RANGE_HEAP;
+
+  if (!strncmp(fields, "[anon", sizeof("[anon") - 1))
+    return RANGE_ANONYMOUS;
+
+  return RANGE_FILE;
+}
+
+static int isStillReadable(size_t address, RANGE_KIND kind)
+{
+  switch (kind)
+    {
+      case RANGE_FILE:
+        return 1;
+
+      // End of heap is read without syscall
+      case RANGE_HEAP:
+        return address < (size_t)sbrk(0);
+
+      case RANGE_ANONYMOUS:
+      default:
+        {
+          pthread_once(&PID_ONCE, initPid);
+
+          char byte = 0;
+
+          iovec local  = {&byte, 1};
+          iovec remote = {(void *)address, 1};
+
+          if (process_vm_readv(SELF_PID, &local, 1, &remote, 1, 0) == 1)
+            return 1;
+
+          return errno == EFAULT ? 0 : -1;
+        }
+    }
+}
+
+static void rememberPid()
+{
+  SELF_PID = getpid();
+}
+
+static void initPid()
+{
+  pthread_atfork(nullptr, nullptr, rememberPid);
+
+  rememberPid();
+}
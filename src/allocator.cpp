@@ -0,0 +1,550 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "allocator.h"
+#include "addressmap.h"
+#include "conf.h"
+#include "systemlike.h"
+
+/// Get memory from malloc() or mmap() if it is large
+/// @param [in] context Unused
+/// @param [in] size Size of memory
+/// @param [in] alignment Alignment of memory
+/// @return Pointer to memory or nullptr
+static void *mallocAllocate(void *context, size_t size, size_t alignment);
+
+/// Change size of memory from mallocAllocate()
+/// @note Large memory is moved by mremap() without copy of pages
+static void *mallocReallocate(void *context, void *pointer, size_t oldSize, size_t newSize, size_t alignment);
+
+/// Free memory from mallocAllocate()
+static void mallocDeallocate(void *context, void *pointer, size_t size);
+
+/// Get memory from malloc() with alignment
+/// @param [in] size Size of memory
+/// @param [in] alignment Alignment of memory
+/// @return Pointer to memory or nullptr
+/// @note Free it with free()
+static void *heapAllocate(size_t size, size_t alignment);
+
+/// Change size of memory from heapAllocate()
+/// @note realloc() keeps only alignof(max_align_t), but when memory grows in place it stays aligned.
+/// Only if realloc() moved memory to address which isn`t aligned, it is copied second time to aligned
+/// memory. If that memory can`t be taken, memory from realloc() is kept, it is aligned to
+/// alignof(max_align_t) only
+static void *heapReallocate(void *pointer, size_t oldSize, size_t newSize, size_t alignment);
+
+/// Check that memory of mallocAllocate() is mapped
+/// @param [in] size Size of memory
+/// @return 1 if memory is mapped or 0 if it is from malloc()
+static int isLarge(size_t size);
+
+/// Get size of page
+/// @return Size of page in bytes
+static size_t pageSize();
+
+/// Get size of mapping for memory of size bytes
+/// @param [in] size Size of memory
+/// @return Size rounded up to pages
+static size_t mappingSize(size_t size);
+
+/// Get memory from arena
+static void *arenaAllocate(void *context, size_t size, size_t alignment);
+
+/// Change size of memory from arena
+/// @note Last allocation grows in place, other are copied
+static void *arenaReallocate(void *context, void *pointer, size_t oldSize, size_t newSize, size_t alignment);
+
+/// Give memory back to arena if it is last allocation
+static void arenaDeallocate(void *context, void *pointer, size_t size);
+
+/// Get memory from pool
+/// @note Alignment must be not bigger than POOL_MIN_BLOCK
+static void *poolAllocate(void *context, size_t size, size_t alignment);
+
+/// Change size of memory from pool
+/// @note Memory isn`t moved if size class is same
+static void *poolReallocate(void *context, void *pointer, size_t oldSize, size_t newSize, size_t alignment);
+
+/// Give memory back to pool
+static void poolDeallocate(void *context, void *pointer, size_t size);
+
+/// Reserve range of addresses and commit first pages
+static void *vmAllocate(void *context, size_t size, size_t alignment);
+
+/// Commit or decommit pages after end of memory
+/// @note Memory is never moved
+static void *vmReallocate(void *context, void *pointer, size_t oldSize, size_t newSize, size_t alignment);
+
+/// Give back range of addresses
+static void vmDeallocate(void *context, void *pointer, size_t size);
+
+/// Get size class of pool for size
+/// @param [in] size Size of memory
+/// @return Index of class or POOL_CLASSES_COUNT if size is too big
+static int poolClass(size_t size);
+
+const StackAllocator MALLOC_ALLOCATOR = {
+  "malloc",
+  mallocAllocate,
+  mallocReallocate,
+  mallocDeallocate,
+  nullptr
+};
+
+void arena_init(StackArena *arena, size_t size, unsigned *error)
+{
+  if (!isPointerCorrect(arena) || !size)
+    {
+      if (isPointerCorrect(error))
+        *error = 1;
+
+      return;
+    }
+
+  arena->memory = (char *) mallocAllocate(nullptr, size, POOL_MIN_BLOCK);
+
+  if (!arena->memory)
+    {
+      if (isPointerCorrect(error))
+        *error = 1;
+
+      return;
+    }
+
+  arena->size       = size;
+  arena->used       = 0;
+  arena->lastOffset = size;
+
+  arena->allocator  = {"arena", arenaAllocate, arenaReallocate, arenaDeallocate, arena};
+}
+
+void arena_reset(StackArena *arena)
+{
+  if (!isPointerCorrect(arena))
+    return;
+
+  // Arrays of stacks which weren`t destroyed mustn`t look correct
+  forgetAddressRange(arena->memory, arena->size);
+
+  arena->used       = 0;
+  arena->lastOffset = arena->size;
+}
+
+void arena_destroy(StackArena *arena)
+{
+  if (!isPointerCorrect(arena))
+    return;
+
+  forgetAddressRange(arena->memory, arena->size);
+
+  mallocDeallocate(nullptr, arena->memory, arena->size);
+
+  arena->memory = nullptr;
+  arena->size   = 0;
+  arena->used   = 0;
+}
+
+void pool_init(StackPool *pool, unsigned *error)
+{
+  if (!isPointerCorrect(pool))
+    {
+      if (isPointerCorrect(error))
+        *error = 1;
+
+      return;
+    }
+
+  for (int i = 0; i < POOL_CLASSES_COUNT; ++i)
+    pool->freeLists[i] = nullptr;
+
+  pool->slabs      = nullptr;
+  pool->slabsCount = 0;
+
+  pthread_mutex_init(&pool->lock, nullptr);
+
+  pool->allocator  = {"pool", poolAllocate, poolReallocate, poolDeallocate, pool};
+}
+
+void pool_destroy(StackPool *pool)
+{
+  if (!isPointerCorrect(pool))
+    return;
+
+  while (pool->slabs)
+    {
+      void *next = *(void **)pool->slabs;
+
+      forgetAddressRange(pool->slabs, ((size_t *)pool->slabs)[1]);
+
+      free(pool->slabs);
+
+      pool->slabs = next;
+    }
+
+  for (int i = 0; i < POOL_CLASSES_COUNT; ++i)
+    pool->freeLists[i] = nullptr;
+
+  pool->slabsCount = 0;
+
+  pthread_mutex_destroy(&pool->lock);
+}
+
+void vmspace_init(StackVmSpace *space, size_t reserveSize, unsigned *error)
+{
+  if (!isPointerCorrect(space))
+    {
+      if (isPointerCorrect(error))
+        *error = 1;
+
+      return;
+    }
+
+  space->reserveSize = mappingSize(reserveSize ? reserveSize : DEFAULT_VM_RESERVE);
+
+  space->allocator   = {"vmspace", vmAllocate, vmReallocate, vmDeallocate, space};
+}
+
+static void *mallocAllocate(void *, size_t size, size_t alignment)
+{
+  if (!isLarge(size))
+    return heapAllocate(size, alignment);
+
+  // Mapping is aligned only to page
+  if (alignment > pageSize())
+    return nullptr;
+
+  void *pointer = mmap(nullptr, mappingSize(size), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  return pointer == MAP_FAILED ? nullptr : pointer;
+}
+
+static void *mallocReallocate(void *context, void *pointer, size_t oldSize, size_t newSize, size_t alignment)
+{
+  int wasLarge  = isLarge(oldSize);
+  int willLarge = isLarge(newSize);
+
+  if (!wasLarge && !willLarge)
+    return heapReallocate(pointer, oldSize, newSize, alignment);
+
+  if (wasLarge && willLarge)
+    {
+      size_t oldMapping = mappingSize(oldSize);
+      size_t newMapping = mappingSize(newSize);
+
+      // Pages are moved by kernel, shrink gives pages after new end back to system
+      void *newPointer = mremap(pointer, oldMapping, newMapping, newMapping < oldMapping ? 0 : MREMAP_MAYMOVE);
+
+      if (newPointer == MAP_FAILED)
+        return nullptr;
+
+      if (newPointer != pointer)
+        forgetAddressRange(pointer, oldMapping);
+      else if (newMapping < oldMapping)
+        forgetAddressRange((char *)pointer + newMapping, oldMapping - newMapping);
+
+      return newPointer;
+    }
+
+  // Memory goes between malloc() and mmap(), so it is copied once
+  void *newPointer = mallocAllocate(context, newSize, alignment);
+
+  if (!newPointer)
+    return nullptr;
+
+  memcpy(newPointer, pointer, oldSize < newSize ? oldSize : newSize);
+
+  mallocDeallocate(context, pointer, oldSize);
+
+  return newPointer;
+}
+
+static void mallocDeallocate(void *, void *pointer, size_t size)
+{
+  if (!pointer)
+    return;
+
+  if (isLarge(size))
+    {
+      forgetAddressRange(pointer, mappingSize(size));
+
+      munmap(pointer, mappingSize(size));
+    }
+  else
+    free(pointer);
+}
+
+static void *heapAllocate(size_t size, size_t alignment)
+{
+  if (alignment <= alignof(max_align_t))
+    return malloc(size ? size : 1);
+
+  void *pointer = nullptr;
+
+  if (posix_memalign(&pointer, alignment, size ? size : 1))
+    return nullptr;
+
+  return pointer;
+}
+
+static void *heapReallocate(void *pointer, size_t oldSize, size_t newSize, size_t alignment)
+{
+  void *newPointer = realloc(pointer, newSize ? newSize : 1);
+
+  if (!newPointer || alignment <= alignof(max_align_t) || !((uintptr_t)newPointer % alignment))
+    return newPointer;
+
+  void *alignedPointer = heapAllocate(newSize, alignment);
+
+  if (!alignedPointer)
+    return newPointer;
+
+  memcpy(alignedPointer, newPointer, oldSize < newSize ? oldSize : newSize);
+
+  free(newPointer);
+
+  return alignedPointer;
+}
+
+static int isLarge(size_t size)
+{
+  return size >= LARGE_ARRAY_SIZE;
+}
+
+static size_t pageSize()
+{
+  static const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+
+  return page;
+}
+
+static size_t mappingSize(size_t size)
+{
+  size_t page = pageSize();
+
+  return (size + page - 1) / page * page;
+}
+
+static void *arenaAllocate(void *context, size_t size, size_t alignment)
+{
+  StackArena *arena = (StackArena *)context;
+
+  size_t offset = (arena->used + alignment - 1) / alignment * alignment;
+
+  if (offset > arena->size || arena->size - offset < size)
+    return nullptr;
+
+  arena->used       = offset + size;
+  arena->lastOffset = offset;
+
+  return arena->memory + offset;
+}
+
+static void *arenaReallocate(void *context, void *pointer, size_t oldSize, size_t newSize, size_t alignment)
+{
+  StackArena *arena = (StackArena *)context;
+
+  if ((char *)pointer == arena->memory + arena->lastOffset)
+    {
+      if (arena->size - arena->lastOffset < newSize)
+        return nullptr;
+
+      arena->used = arena->lastOffset + newSize;
+
+      return pointer;
+    }
+
+  void *newPointer = arenaAllocate(context, newSize, alignment);
+
+  if (!newPointer)
+    return nullptr;
+
+  memcpy(newPointer, pointer, oldSize < newSize ? oldSize : newSize);
+
+  return newPointer;
+}
+
+static void arenaDeallocate(void *context, void *pointer, size_t)
+{
+  StackArena *arena = (StackArena *)context;
+
+  if ((char *)pointer == arena->memory + arena->lastOffset)
+    {
+      arena->used       = arena->lastOffset;
+      arena->lastOffset = arena->size;
+    }
+}
+
+static void *poolAllocate(void *context, size_t size, size_t alignment)
+{
+  StackPool *pool = (StackPool *)context;
+
+  if (alignment > POOL_MIN_BLOCK)
+    return nullptr;
+
+  int sizeClass = poolClass(size);
+
+  if (sizeClass == POOL_CLASSES_COUNT)
+    return mallocAllocate(nullptr, size, POOL_MIN_BLOCK);
+
+  pthread_mutex_lock(&pool->lock);
+
+  if (!pool->freeLists[sizeClass])
+    {
+      size_t blockSize = POOL_MIN_BLOCK << sizeClass;
+
+      size_t slabSize  = POOL_MIN_BLOCK + POOL_SLAB_BLOCKS*blockSize;
+
+      // First POOL_MIN_BLOCK bytes of slab keep pointer to next slab and size of slab
+      char *slab = (char *) heapAllocate(slabSize, POOL_MIN_BLOCK);
+
+      if (!slab)
+        {
+          pthread_mutex_unlock(&pool->lock);
+
+          return nullptr;
+        }
+
+      *(void **)slab       = pool->slabs;
+      ((size_t *)slab)[1] = slabSize;
+
+      pool->slabs = slab;
+      ++pool->slabsCount;
+
+      for (size_t i = 0; i < POOL_SLAB_BLOCKS; ++i)
+        {
+          void *block = slab + POOL_MIN_BLOCK + i*blockSize;
+
+          *(void **)block = pool->freeLists[sizeClass];
+
+          pool->freeLists[sizeClass] = block;
+        }
+    }
+
+  void *block = pool->freeLists[sizeClass];
+
+  pool->freeLists[sizeClass] = *(void **)block;
+
+  pthread_mutex_unlock(&pool->lock);
+
+  return block;
+}
+
+static void *poolReallocate(void *context, void *pointer, size_t oldSize, size_t newSize, size_t alignment)
+{
+  int oldClass = poolClass(oldSize);
+  int newClass = poolClass(newSize);
+
+  if (oldClass == newClass && oldClass != POOL_CLASSES_COUNT)
+    return pointer;
+
+  if (oldClass == POOL_CLASSES_COUNT && newClass == POOL_CLASSES_COUNT)
+    return mallocReallocate(nullptr, pointer, oldSize, newSize, POOL_MIN_BLOCK);
+
+  void *newPointer = poolAllocate(context, newSize, alignment);
+
+  if (!newPointer)
+    return nullptr;
+
+  memcpy(newPointer, pointer, oldSize < newSize ? oldSize : newSize);
+
+  poolDeallocate(context, pointer, oldSize);
+
+  return newPointer;
+}
+
+static void poolDeallocate(void *context, void *pointer, size_t size)
+{
+  StackPool *pool = (StackPool *)context;
+
+  int sizeClass = poolClass(size);
+
+  if (sizeClass == POOL_CLASSES_COUNT)
+    {
+      mallocDeallocate(nullptr, pointer, size);
+
+      return;
+    }
+
+  pthread_mutex_lock(&pool->lock);
+
+  *(void **)pointer = pool->freeLists[sizeClass];
+
+  pool->freeLists[sizeClass] = pointer;
+
+  pthread_mutex_unlock(&pool->lock);
+}
+
+static void *vmAllocate(void *context, size_t size, size_t alignment)
+{
+  StackVmSpace *space = (StackVmSpace *)context;
+
+  if (alignment > pageSize() || size > space->reserveSize)
+    return nullptr;
+
+  char *begin = (char *) mmap(nullptr, space->reserveSize, PROT_NONE,
+                              MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+  if (begin == MAP_FAILED)
+    return nullptr;
+
+  if (mprotect(begin, mappingSize(size), PROT_READ | PROT_WRITE))
+    {
+      munmap(begin, space->reserveSize);
+
+      return nullptr;
+    }
+
+  return begin;
+}
+
+static void *vmReallocate(void *context, void *pointer, size_t oldSize, size_t newSize, size_t)
+{
+  StackVmSpace *space = (StackVmSpace *)context;
+
+  if (newSize > space->reserveSize)
+    return nullptr;
+
+  size_t oldMapping = mappingSize(oldSize);
+  size_t newMapping = mappingSize(newSize);
+
+  if (newMapping > oldMapping)
+    {
+      if (mprotect((char *)pointer + oldMapping, newMapping - oldMapping, PROT_READ | PROT_WRITE))
+        return nullptr;
+    }
+  else if (newMapping < oldMapping)
+    {
+      forgetAddressRange((char *)pointer + newMapping, oldMapping - newMapping);
+
+      // Pages are given back to system, their addresses stay reserved
+      madvise ((char *)pointer + newMapping, oldMapping - newMapping, MADV_DONTNEED);
+      mprotect((char *)pointer + newMapping, oldMapping - newMapping, PROT_NONE);
+    }
+
+  return pointer;
+}
+
+static void vmDeallocate(void *context, void *pointer, size_t)
+{
+  StackVmSpace *space = (StackVmSpace *)context;
+
+  if (pointer)
+    {
+      forgetAddressRange(pointer, space->reserveSize);
+
+      munmap(pointer, space->reserveSize);
+    }
+}
+
+static int poolClass(size_t size)
+{
+  int sizeClass = 0;
+
+  while (sizeClass < POOL_CLASSES_COUNT && (POOL_MIN_BLOCK << sizeClass) < size)
+    ++sizeClass;
+
+  return sizeClass;
+}
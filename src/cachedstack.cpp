@@ -0,0 +1,287 @@
+#include <stdlib.h>
+#include "cachedstack.h"
+#include "systemlike.h"
+
+/// Give first count elements of cache to shared stack
+/// @param [in/out] cache Pointer to cache
+/// @param [in] count Count of elements
+/// @param [out] error Return error code
+static void spill(StackCache *cache, size_t count, unsigned *error);
+
+/// Take up to batch elements from shared stack into empty cache
+/// @param [in/out] cache Pointer to cache
+/// @param [out] error Return error code
+static void refill(StackCache *cache, unsigned *error);
+
+/// Add stats to other stats
+/// @param [in/out] target Stats for adding
+/// @param [in] source Added stats
+static void addStats(StackCacheStats *target, const StackCacheStats *source);
+
+void do_sharedstack_init(SharedStack *stk, size_t capacity, void (*copyFunction)(Element *, const Element *),
+                         const char *name, const char *fileName, const char *functionName, int line,
+                         unsigned *error)
+{
+  if (!isPointerCorrect(stk))
+    {
+      if (isPointerCorrect(error))
+        *error = 1;
+
+      return;
+    }
+
+  unsigned initError = 0;
+
+  do_stack_init(&stk->stack, capacity, copyFunction, nullptr, name, fileName, functionName, line, &initError);
+
+  if (initError)
+    {
+      if (isPointerCorrect(error))
+        *error = initError;
+
+      return;
+    }
+
+  pthread_mutex_init(&stk->lock, nullptr);
+
+  stk->stats = {};
+}
+
+void sharedstack_destroy(SharedStack *stk, unsigned *error)
+{
+  if (!isPointerCorrect(stk))
+    {
+      if (isPointerCorrect(error))
+        *error = 1;
+
+      return;
+    }
+
+  stack_destroy(&stk->stack, error);
+
+  pthread_mutex_destroy(&stk->lock);
+}
+
+void sharedstack_stats(SharedStack *stk, StackCacheStats *stats)
+{
+  if (!isPointerCorrect(stk) || !isPointerCorrect(stats))
+    return;
+
+  pthread_mutex_lock(&stk->lock);
+
+  *stats = stk->stats;
+
+  pthread_mutex_unlock(&stk->lock);
+}
+
+void stackcache_init(StackCache *cache, SharedStack *shared, size_t capacity, unsigned *error)
+{
+  if (!isPointerCorrect(cache) || !isPointerCorrect(shared))
+    {
+      if (isPointerCorrect(error))
+        *error = 1;
+
+      return;
+    }
+
+  if (capacity < 2)
+    capacity = DEFAULT_CACHE_CAPACITY;
+
+  cache->elements = (Element *) calloc(capacity, sizeof(Element));
+
+  if (!isPointerCorrect(cache->elements))
+    {
+      if (isPointerCorrect(error))
+        *error = 1;
+
+      return;
+    }
+
+  cache->shared   = shared;
+  cache->size     = 0;
+  cache->capacity = capacity;
+  cache->batch    = capacity / 2;
+  cache->stats    = {};
+}
+
+void stackcache_destroy(StackCache *cache, unsigned *error)
+{
+  if (!isPointerCorrect(cache) || !isPointerCorrect(cache->shared))
+    {
+      if (isPointerCorrect(error))
+        *error = 1;
+
+      return;
+    }
+
+  unsigned flushError = 0;
+
+  stackcache_flush(cache, &flushError);
+
+  // Elements which shared stack didn`t take are kept in cache
+  if (flushError)
+    {
+      if (isPointerCorrect(error))
+        *error = flushError;
+
+      return;
+    }
+
+  pthread_mutex_lock(&cache->shared->lock);
+
+  addStats(&cache->shared->stats, &cache->stats);
+
+  pthread_mutex_unlock(&cache->shared->lock);
+
+  free(cache->elements);
+
+  cache->elements = nullptr;
+  cache->shared   = nullptr;
+  cache->size     = 0;
+  cache->capacity = 0;
+}
+
+void stackcache_push(StackCache *cache, const Element *element, unsigned *error)
+{
+  if (!isPointerCorrect(cache) || !isPointerCorrect(cache->shared) || !isPointerCorrect(element))
+    {
+      if (isPointerCorrect(error))
+        *error = 1;
+
+      return;
+    }
+
+  if (cache->size == cache->capacity)
+    {
+      unsigned spillError = 0;
+
+      spill(cache, cache->batch, &spillError);
+
+      if (spillError)
+        {
+          if (isPointerCorrect(error))
+            *error = spillError;
+
+          return;
+        }
+    }
+  else
+    ++cache->stats.localHits;
+
+  cache->shared->stack.copyFunction(&cache->elements[cache->size++], element);
+}
+
+void stackcache_pop(StackCache *cache, Element *element, unsigned *error)
+{
+  if (!isPointerCorrect(cache) || !isPointerCorrect(cache->shared) || !isPointerCorrect(element))
+    {
+      if (isPointerCorrect(error))
+        *error = 1;
+
+      return;
+    }
+
+  if (!cache->size)
+    {
+      unsigned refillError = 0;
+
+      refill(cache, &refillError);
+
+      if (refillError || !cache->size)
+        {
+          if (isPointerCorrect(error))
+            *error = refillError ? refillError : 1;
+
+          return;
+        }
+    }
+  else
+    ++cache->stats.localHits;
+
+  cache->shared->stack.copyFunction(element, &cache->elements[--cache->size]);
+}
+
+void stackcache_flush(StackCache *cache, unsigned *error)
+{
+  if (!isPointerCorrect(cache) || !isPointerCorrect(cache->shared))
+    {
+      if (isPointerCorrect(error))
+        *error = 1;
+
+      return;
+    }
+
+  if (cache->size)
+    spill(cache, cache->size, error);
+}
+
+static void spill(StackCache *cache, size_t count, unsigned *error)
+{
+  unsigned spillError = 0;
+
+  pthread_mutex_lock(&cache->shared->lock);
+
+  stack_push_n(&cache->shared->stack, cache->elements, count, &spillError);
+
+  pthread_mutex_unlock(&cache->shared->lock);
+
+  if (spillError)
+    {
+      if (isPointerCorrect(error))
+        *error = spillError;
+
+      return;
+    }
+
+  for (size_t i = count; i < cache->size; ++i)
+    cache->shared->stack.copyFunction(&cache->elements[i - count], &cache->elements[i]);
+
+  cache->size -= count;
+
+  ++cache->stats.spills;
+
+  cache->stats.spilledElements += count;
+}
+
+static void refill(StackCache *cache, unsigned *error)
+{
+  unsigned refillError = 0;
+
+  pthread_mutex_lock(&cache->shared->lock);
+
+  size_t count = cache->shared->stack.lastElementIndex;
+
+  if (count > cache->batch)
+    count = cache->batch;
+
+  if (count)
+    stack_pop_n(&cache->shared->stack, cache->elements, count, &refillError);
+
+  pthread_mutex_unlock(&cache->shared->lock);
+
+  if (refillError)
+    {
+      if (isPointerCorrect(error))
+        *error = refillError;
+
+      return;
+    }
+
+  if (!count)
+    return;
+
+  cache->size = count;
+
+  ++cache->stats.refills;
+
+  cache->stats.refilledElements += count;
+}
+
+static void addStats(StackCacheStats *target, const StackCacheStats *source)
+{
+  target->localHits        += source->localHits;
+  target->spills           += source->spills;
+  target->refills          += source->refills;
+  target->spilledElements  += source->spilledElements;
+  target->refilledElements += source->refilledElements;
+}
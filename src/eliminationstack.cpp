@@ -0,0 +1,221 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include "eliminationstack.h"
+#include "systemlike.h"
+
+unsigned enum EXCHANGE_STATE {
+  EXCHANGE_EMPTY   , // Slot is free
+  EXCHANGE_BUSY    , // Push writes element or takes it back
+  EXCHANGE_WAITING , // Element waits for pop
+  EXCHANGE_TAKING  , // Pop reads element
+  EXCHANGE_TAKEN   , // Element was read, push must free slot
+};
+
+/// Pause for spin loops
+static inline void cpuRelax();
+
+/// Get random slot of arena
+/// @param [in] stk Pointer to stack
+/// @return Pointer to slot
+static EliminationSlot *randomSlot(EliminationStack *stk);
+
+/// Offer element in arena for backoff spins
+/// @param [in/out] stk Pointer to stack
+/// @param [in] element Pointer to element
+/// @return Was element taken by pop
+static int offerElement(EliminationStack *stk, const Element *element);
+
+/// Look for offered element in arena for backoff spins
+/// @param [in/out] stk Pointer to stack
+/// @param [out] element Container for element
+/// @return Was element taken
+static int takeElement(EliminationStack *stk, Element *element);
+
+void do_elimination_init(EliminationStack *stk, size_t capacity,
+                         void (*copyFunction)(Element *, const Element *),
+                         size_t arenaSize, unsigned backoff,
+                         const char *name, const char *fileName, const char *functionName, int line,
+                         unsigned *error)
+{
+  if (!isPointerCorrect(stk))
+    {
+      if (isPointerCorrect(error))
+        *error = 1;
+
+      return;
+    }
+
+  unsigned initError = 0;
+
+  do_lockfree_init(&stk->stack, capacity, copyFunction, name, fileName, functionName, line, &initError);
+
+  if (initError)
+    {
+      if (isPointerCorrect(error))
+        *error = initError;
+
+      return;
+    }
+
+  stk->arenaSize = arenaSize ? arenaSize : DEFAULT_ARENA_SIZE;
+  stk->backoff   = backoff   ? backoff   : DEFAULT_BACKOFF;
+
+  stk->arena = (EliminationSlot *) aligned_alloc(CACHE_LINE_SIZE, stk->arenaSize * sizeof(EliminationSlot));
+
+  if (!isPointerCorrect(stk->arena))
+    {
+      lockfree_destroy(&stk->stack);
+
+      if (isPointerCorrect(error))
+        *error = 1;
+
+      return;
+    }
+
+  for (size_t i = 0; i < stk->arenaSize; ++i)
+    stk->arena[i].state.store(EXCHANGE_EMPTY, std::memory_order_relaxed);
+
+  stk->eliminations.store(0, std::memory_order_release);
+}
+
+void elimination_destroy(EliminationStack *stk, unsigned *error)
+{
+  if (!isPointerCorrect(stk))
+    {
+      if (isPointerCorrect(error))
+        *error = 1;
+
+      return;
+    }
+
+  lockfree_destroy(&stk->stack, error);
+
+  free(stk->arena);
+
+  stk->arena     = nullptr;
+  stk->arenaSize = 0;
+}
+
+void elimination_push(EliminationStack *stk, const Element *element, unsigned *error)
+{
+  // Node is taken once, failed CAS doesn`t give it back to free list
+  uint32_t number = lockfree_takeNode(&stk->stack, element, error);
+
+  if (!number)
+    return;
+
+  while (lockfree_tryPushNode(&stk->stack, number) == LOCKFREE_CONTENTION)
+    if (offerElement(stk, element))
+      {
+        lockfree_releaseNode(&stk->stack, number);
+
+        stk->eliminations.fetch_add(1, std::memory_order_relaxed);
+
+        return;
+      }
+}
+
+void elimination_pop(EliminationStack *stk, Element *element, unsigned *error)
+{
+  while (lockfree_tryPop(&stk->stack, element, error) == LOCKFREE_CONTENTION)
+    if (takeElement(stk, element))
+      return;
+}
+
+size_t elimination_size(const EliminationStack *stk, unsigned *error)
+{
+  return lockfree_size(&stk->stack, error);
+}
+
+size_t elimination_count(const EliminationStack *stk)
+{
+  return stk->eliminations.load(std::memory_order_relaxed);
+}
+
+static inline void cpuRelax()
+{
+#if defined __x86_64__ || defined __i386__
+
+  __builtin_ia32_pause();
+
+#endif
+}
+
+static EliminationSlot *randomSlot(EliminationStack *stk)
+{
+  static thread_local uint32_t seed = 0;
+
+  if (!seed)
+    seed = (uint32_t)(uintptr_t)&seed | 1;
+
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed <<  5;
+
+  return &stk->arena[seed % stk->arenaSize];
+}
+
+static int offerElement(EliminationStack *stk, const Element *element)
+{
+  EliminationSlot *slot = randomSlot(stk);
+
+  unsigned state = EXCHANGE_EMPTY;
+
+  if (!slot->state.compare_exchange_strong(state, EXCHANGE_BUSY, std::memory_order_acquire))
+    return 0;
+
+  stk->stack.copyFunction(&slot->element, element);
+
+  slot->state.store(EXCHANGE_WAITING, std::memory_order_release);
+
+  for (unsigned i = 0; i < stk->backoff; ++i)
+    {
+      if (slot->state.load(std::memory_order_acquire) == EXCHANGE_TAKEN)
+        {
+          slot->state.store(EXCHANGE_EMPTY, std::memory_order_release);
+
+          return 1;
+        }
+
+      cpuRelax();
+    }
+
+  state = EXCHANGE_WAITING;
+
+  if (slot->state.compare_exchange_strong(state, EXCHANGE_BUSY, std::memory_order_acquire))
+    {
+      slot->state.store(EXCHANGE_EMPTY, std::memory_order_release);
+
+      return 0;
+    }
+
+  while (slot->state.load(std::memory_order_acquire) != EXCHANGE_TAKEN)
+    cpuRelax();
+
+  slot->state.store(EXCHANGE_EMPTY, std::memory_order_release);
+
+  return 1;
+}
+
+static int takeElement(EliminationStack *stk, Element *element)
+{
+  EliminationSlot *slot = randomSlot(stk);
+
+  for (unsigned i = 0; i < stk->backoff; ++i)
+    {
+      unsigned state = EXCHANGE_WAITING;
+
+      if (slot->state.compare_exchange_strong(state, EXCHANGE_TAKING, std::memory_order_acquire))
+        {
+          stk->stack.copyFunction(element, &slot->element);
+
+          slot->state.store(EXCHANGE_TAKEN, std::memory_order_release);
+
+          return 1;
+        }
+
+      cpuRelax();
+    }
+
+  return 0;
+}
@@ -0,0 +1,219 @@
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <atomic>
+#include "guardpages.h"
+#include "addressmap.h"
+
+/// Array with guard pages
+typedef struct {
+  std::atomic<uintptr_t> begin; // Start of mapping (left guard page)
+  std::atomic<uintptr_t> end;   // End of mapping (after right guard page)
+
+  std::atomic<const Stack *> owner;
+} GuardRegion;
+
+static GuardRegion REGIONS[GUARD_REGIONS_COUNT];
+
+static pthread_once_t HANDLER_ONCE = PTHREAD_ONCE_INIT;
+
+static struct sigaction OLD_ACTION = {};
+
+/// Get size of page
+/// @return Size of page in bytes
+static size_t pageSize();
+
+/// Get size of mapping for memory of size bytes
+/// @param [in] size Size of memory
+/// @return Size of data pages without guard pages
+static size_t dataPagesSize(size_t size);
+
+/// Set SIGSEGV handler
+static void setHandler();
+
+/// SIGSEGV handler
+/// @param [in] signal Number of signal
+/// @param [in] info Info about fault
+/// @param [in] context Context of thread
+static void guardHandler(int signal, siginfo_t *info, void *context);
+
+/// Write string into file descriptor (async-signal-safe)
+/// @param [in] fd File descriptor
+/// @param [in] string String for writing
+static void writeString(int fd, const char *string);
+
+/// Write number into file descriptor (async-signal-safe)
+/// @param [in] fd File descriptor
+/// @param [in] value Number for writing
+/// @param [in] base 10 or 16
+static void writeNumber(int fd, uintptr_t value, unsigned base);
+
+void *guardAlloc(size_t size, const Stack *owner)
+{
+  pthread_once(&HANDLER_ONCE, setHandler);
+
+  size_t page = pageSize();
+  size_t data = dataPagesSize(size);
+
+  char *begin = (char *) mmap(nullptr, data + 2*page, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  if (begin == MAP_FAILED)
+    return nullptr;
+
+  if (mprotect(begin + page, data, PROT_READ | PROT_WRITE))
+    {
+      munmap(begin, data + 2*page);
+
+      return nullptr;
+    }
+
+  for (int i = 0; i < GUARD_REGIONS_COUNT; ++i)
+    {
+      const Stack *freeOwner = nullptr;
+
+      if (REGIONS[i].owner.compare_exchange_strong(freeOwner, owner))
+        {
+          REGIONS[i].begin.store((uintptr_t)begin);
+          REGIONS[i].end.store((uintptr_t)(begin + data + 2*page));
+
+          break;
+        }
+    }
+
+  char *memory = begin + page + data - size;
+
+  addKnownRange(memory, size);
+
+  return memory;
+}
+
+void guardFree(void *data, size_t size)
+{
+  if (!data)
+    return;
+
+  size_t page = pageSize();
+
+  char *begin = (char *)data + size - dataPagesSize(size) - page;
+
+  removeKnownRange(data);
+
+  for (int i = 0; i < GUARD_REGIONS_COUNT; ++i)
+    if (REGIONS[i].begin.load() == (uintptr_t)begin)
+      {
+        REGIONS[i].begin.store(0);
+        REGIONS[i].end.store(0);
+        REGIONS[i].owner.store(nullptr);
+
+        break;
+      }
+
+  forgetAddressRange(begin, dataPagesSize(size) + 2*page);
+
+  munmap(begin, dataPagesSize(size) + 2*page);
+}
+
+static size_t pageSize()
+{
+  static const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+
+  return page;
+}
+
+static size_t dataPagesSize(size_t size)
+{
+  size_t page = pageSize();
+
+  return size ? (size + page - 1) / page * page : page;
+}
+
+static void setHandler()
+{
+  struct sigaction action = {};
+
+  action.sa_sigaction = guardHandler;
+  action.sa_flags     = SA_SIGINFO | SA_ONSTACK;
+
+  sigemptyset(&action.sa_mask);
+
+  sigaction(SIGSEGV, &action, &OLD_ACTION);
+}
+
+static void guardHandler(int signal, siginfo_t *info, void *context)
+{
+  uintptr_t address = (uintptr_t)info->si_addr;
+
+  for (int i = 0; i < GUARD_REGIONS_COUNT; ++i)
+    {
+      const Stack *stk = REGIONS[i].owner.load();
+
+      if (!stk || address < REGIONS[i].begin.load() || address >= REGIONS[i].end.load())
+        continue;
+
+      writeString(STDERR_FILENO, "\nGuard page of stack was touched at 0x");
+      writeNumber(STDERR_FILENO, address, 16);
+      writeString(STDERR_FILENO, ":\nStack[0x");
+      writeNumber(STDERR_FILENO, (uintptr_t)stk, 16);
+      writeString(STDERR_FILENO, "]");
+
+#ifndef RELEASE_BUILD_
+
+      writeString(STDERR_FILENO, " \"");
+      writeString(STDERR_FILENO, stk->info.name);
+      writeString(STDERR_FILENO, "\" at ");
+      writeString(STDERR_FILENO, stk->info.functionName);
+      writeString(STDERR_FILENO, " at ");
+      writeString(STDERR_FILENO, stk->info.fileName);
+      writeString(STDERR_FILENO, " (");
+      writeNumber(STDERR_FILENO, (uintptr_t)stk->info.line, 10);
+      writeString(STDERR_FILENO, ")");
+
+#endif
+
+      writeString(STDERR_FILENO, "\nArray: 0x");
+      writeNumber(STDERR_FILENO, (uintptr_t)stk->array, 16);
+      writeString(STDERR_FILENO, " Capacity: ");
+      writeNumber(STDERR_FILENO, stk->capacity, 10);
+      writeString(STDERR_FILENO, " Size: ");
+      writeNumber(STDERR_FILENO, stk->lastElementIndex, 10);
+      writeString(STDERR_FILENO, "\n");
+
+      break;
+    }
+
+  // After return faulting instruction is run again and old handler gets signal
+  sigaction(SIGSEGV, &OLD_ACTION, nullptr);
+
+  (void)signal;
+  (void)context;
+}
+
+static void writeString(int fd, const char *string)
+{
+  if (!string)
+    string = "nullptr";
+
+  ssize_t result = write(fd, string, strlen(string));
+
+  (void)result;
+}
+
+static void writeNumber(int fd, uintptr_t value, unsigned base)
+{
+  char buffer[32] = {};
+
+  int position = (int)sizeof(buffer) - 1;
+
+  do
+    {
+      buffer[--position] = "0123456789abcdef"[value % base];
+
+      value /= base;
+    }
+  while (value && position);
+
+  writeString(fd, buffer + position);
+}
@@ -1,18 +1,471 @@
 #include <stdio.h>
+#include <stdint.h>
+#include <string.h>
 #include "systemlike.h"
 #include "hash.h"
 
+#if defined(__x86_64__)
+
+#include <immintrin.h>
+
+#define HASH_X86_
+
+#endif
+
 const int DEFAULT_HASH_OFFSET = 17;
 
+const uint32_t CRC32C_POLYNOMIAL = 0x82F63B78u;
+
+const uint32_t XXH_PRIME_1 = 0x9E3779B1u;
+const uint32_t XXH_PRIME_2 = 0x85EBCA77u;
+const uint32_t XXH_PRIME_3 = 0xC2B2AE3Du;
+const uint32_t XXH_PRIME_4 = 0x27D4EB2Fu;
+const uint32_t XXH_PRIME_5 = 0x165667B1u;
+
+/// Table for byte-at-a-time CRC32C
+typedef struct {
+  uint32_t values[256];
+} Crc32cTable;
+
+/// Hash function of one family
+typedef uint32_t (*HashKernel)(const unsigned char *data, size_t size);
+
+/// Position-weighted hash of slots with one family
+typedef unsigned (*SlotsKernel)(const unsigned char *array, size_t count, size_t elementSize, size_t firstIndex);
+
+/// Mix bits of value (finalizer of MurmurHash3)
+/// @param [in] value Value for mixing
+/// @return Mixed value
+static inline unsigned mixHash(unsigned value);
+
+/// Mix hash of slot with its index
+/// @param [in] hash Hash of slot data
+/// @param [in] index Index of slot in array
+/// @return Contribution of slot to array hash
+static inline unsigned placeHash(unsigned hash, size_t index);
+
+/// Choose the fastest hash function of family for this CPU
+/// @param [in] family Family of hash function
+/// @return Hash function
+static HashKernel getKernel(HASH_FAMILY family);
+
+/// Choose the fastest slots hash of family for this CPU
+/// @param [in] family Family of hash function
+/// @return Slots hash function
+static SlotsKernel getSlotsKernel(HASH_FAMILY family);
+
+/// Calc DJB hash without check of pointer
+/// @param [in] data Data which need hash
+/// @param [in] size Size of data
+/// @return Hash of data
+static inline uint32_t djbScalar(const unsigned char *data, size_t size);
+
+/// Calc position-weighted hash of slots with DJB
+/// @param [in] array Pointer to first slot
+/// @param [in] count Count of slots
+/// @param [in] elementSize Size of one slot
+/// @param [in] firstIndex Index of first slot in whole array
+/// @return Sum of slot hashes
+static unsigned slotsDjb(const unsigned char *array, size_t count, size_t elementSize, size_t firstIndex);
+
+/// Calc position-weighted hash of slots with table CRC32C
+/// @param [in] array Pointer to first slot
+/// @param [in] count Count of slots
+/// @param [in] elementSize Size of one slot
+/// @param [in] firstIndex Index of first slot in whole array
+/// @return Sum of slot hashes
+static unsigned slotsCrc32c(const unsigned char *array, size_t count, size_t elementSize, size_t firstIndex);
+
+/// Calc position-weighted hash of slots with xxHash32
+/// @param [in] array Pointer to first slot
+/// @param [in] count Count of slots
+/// @param [in] elementSize Size of one slot
+/// @param [in] firstIndex Index of first slot in whole array
+/// @return Sum of slot hashes
+/// @note Slots are short, so vector version isn`t used for them
+static unsigned slotsXxh32(const unsigned char *array, size_t count, size_t elementSize, size_t firstIndex);
+
+/// Build table for crc32cScalar()
+/// @return Table of CRC32C for every byte
+static Crc32cTable makeCrc32cTable();
+
+/// Rotate bits of value left
+/// @param [in] value Value for rotate
+/// @param [in] shift Count of bits (from 1 to 31)
+/// @return Rotated value
+static inline uint32_t rotateLeft(uint32_t value, int shift);
+
+/// Read 32-bit little-endian word without alignment
+/// @param [in] data Pointer to first byte
+/// @return Word
+static inline uint32_t load32(const unsigned char *data);
+
+/// Calc CRC32C byte by byte with table
+/// @param [in] data Data which need hash
+/// @param [in] size Size of data
+/// @return CRC32C of data
+static uint32_t crc32cScalar(const unsigned char *data, size_t size);
+
+/// Calc xxHash32 with seed 0
+/// @param [in] data Data which need hash
+/// @param [in] size Size of data
+/// @return xxHash32 of data
+static uint32_t xxh32Scalar(const unsigned char *data, size_t size);
+
+/// Calc tail and avalanche of xxHash32
+/// @param [in] hash Hash after lanes
+/// @param [in] data Rest of data (less than 16 bytes)
+/// @param [in] size Size of rest
+/// @return Final hash
+static uint32_t xxh32Finish(uint32_t hash, const unsigned char *data, size_t size);
+
+#ifdef HASH_X86_
+
+/// Calc CRC32C with SSE4.2 crc32 instruction
+/// @param [in] data Data which need hash
+/// @param [in] size Size of data
+/// @return CRC32C of data
+static inline uint32_t crc32cSse42(const unsigned char *data, size_t size);
+
+/// Calc position-weighted hash of slots with SSE4.2 crc32 instruction
+/// @param [in] array Pointer to first slot
+/// @param [in] count Count of slots
+/// @param [in] elementSize Size of one slot
+/// @param [in] firstIndex Index of first slot in whole array
+/// @return Sum of slot hashes
+static unsigned slotsCrc32cSse42(const unsigned char *array, size_t count, size_t elementSize, size_t firstIndex);
+
+/// Calc xxHash32 with seed 0, four lanes are in one SSE register
+/// @param [in] data Data which need hash
+/// @param [in] size Size of data
+/// @return xxHash32 of data
+static uint32_t xxh32Sse41(const unsigned char *data, size_t size);
+
+#endif
+
 unsigned getHash(const void *data, size_t size)
 {
   if (!isPointerCorrect(data))
     return 0;
 
+  return djbScalar((const unsigned char *)data, size);
+}
+
+unsigned getFamilyHash(const void *data, size_t size, HASH_FAMILY family)
+{
+  if (!isPointerCorrect(data))
+    return 0;
+
+  return getKernel(family)((const unsigned char *)data, size);
+}
+
+const char *hashFamilyName(HASH_FAMILY family)
+{
+  switch (family)
+    {
+      case HASH_DJB:
+        return "DJB";
+
+      case HASH_CRC32C:
+        return "CRC32C";
+
+      case HASH_XXH32:
+        return "XXH32";
+
+      default:
+        return "UNKNOWN";
+    }
+}
+
+unsigned getSlotHash(const void *data, size_t size, size_t index, HASH_FAMILY family)
+{
+  return getSlotsKernel(family)((const unsigned char *)data, 1, size, index);
+}
+
+unsigned getArrayHash(const void *array, size_t count, size_t elementSize, HASH_FAMILY family, size_t firstIndex)
+{
+  if (!isPointerCorrect(array))
+    return 0;
+
+  return getSlotsKernel(family)((const unsigned char *)array, count, elementSize, firstIndex);
+}
+
+static HashKernel getKernel(HASH_FAMILY family)
+{
+#ifdef HASH_X86_
+
+  static const HashKernel crc32c = __builtin_cpu_supports("sse4.2") ? crc32cSse42 : crc32cScalar;
+  static const HashKernel xxh32  = __builtin_cpu_supports("sse4.1") ? xxh32Sse41  : xxh32Scalar;
+
+#else
+
+  static const HashKernel crc32c = crc32cScalar;
+  static const HashKernel xxh32  = xxh32Scalar;
+
+#endif
+
+  switch (family)
+    {
+      case HASH_CRC32C:
+        return crc32c;
+
+      case HASH_XXH32:
+        return xxh32;
+
+      case HASH_DJB:
+      default:
+        return djbScalar;
+    }
+}
+
+static SlotsKernel getSlotsKernel(HASH_FAMILY family)
+{
+#ifdef HASH_X86_
+
+  static const SlotsKernel crc32c = __builtin_cpu_supports("sse4.2") ? slotsCrc32cSse42 : slotsCrc32c;
+
+#else
+
+  static const SlotsKernel crc32c = slotsCrc32c;
+
+#endif
+
+  switch (family)
+    {
+      case HASH_CRC32C:
+        return crc32c;
+
+      case HASH_XXH32:
+        return slotsXxh32;
+
+      case HASH_DJB:
+      default:
+        return slotsDjb;
+    }
+}
+
+static inline uint32_t djbScalar(const unsigned char *data, size_t size)
+{
   int hash = DEFAULT_HASH_OFFSET;
 
   for (const char *ptr = (const char *)data; ptr != (const char *)data + size; ++ptr)
     hash += (hash << 5) + hash + *ptr;
 
-  return (unsigned)hash;
+  return (uint32_t)hash;
+}
+
+static unsigned slotsDjb(const unsigned char *array, size_t count, size_t elementSize, size_t firstIndex)
+{
+  unsigned hash = 0;
+
+  for (size_t i = 0; i < count; ++i, array += elementSize)
+    hash += placeHash(djbScalar(array, elementSize), firstIndex + i);
+
+  return hash;
+}
+
+static unsigned slotsCrc32c(const unsigned char *array, size_t count, size_t elementSize, size_t firstIndex)
+{
+  unsigned hash = 0;
+
+  for (size_t i = 0; i < count; ++i, array += elementSize)
+    hash += placeHash(crc32cScalar(array, elementSize), firstIndex + i);
+
+  return hash;
 }
+
+static unsigned slotsXxh32(const unsigned char *array, size_t count, size_t elementSize, size_t firstIndex)
+{
+  unsigned hash = 0;
+
+  for (size_t i = 0; i < count; ++i, array += elementSize)
+    hash += placeHash(xxh32Scalar(array, elementSize), firstIndex + i);
+
+  return hash;
+}
+
+static inline unsigned placeHash(unsigned hash, size_t index)
+{
+  return mixHash(hash + ((unsigned)index ^ (unsigned)(index >> 32)) * XXH_PRIME_1);
+}
+
+static inline unsigned mixHash(unsigned value)
+{
+  value ^= value >> 16;
+  value *= 0x85EBCA6Bu;
+  value ^= value >> 13;
+  value *= 0xC2B2AE35u;
+  value ^= value >> 16;
+
+  return value;
+}
+
+static Crc32cTable makeCrc32cTable()
+{
+  Crc32cTable table = {};
+
+  for (uint32_t i = 0; i < 256; ++i)
+    {
+      uint32_t value = i;
+
+      for (int bit = 0; bit < 8; ++bit)
+        value = (value >> 1) ^ (CRC32C_POLYNOMIAL & (0u - (value & 1u)));
+
+      table.values[i] = value;
+    }
+
+  return table;
+}
+
+static uint32_t crc32cScalar(const unsigned char *data, size_t size)
+{
+  static const Crc32cTable table = makeCrc32cTable();
+
+  uint32_t crc = ~0u;
+
+  for (size_t i = 0; i < size; ++i)
+    crc = (crc >> 8) ^ table.values[(crc ^ data[i]) & 0xFFu];
+
+  return ~crc;
+}
+
+static inline uint32_t rotateLeft(uint32_t value, int shift)
+{
+  return (value << shift) | (value >> (32 - shift));
+}
+
+static inline uint32_t load32(const unsigned char *data)
+{
+  uint32_t value = 0;
+
+  memcpy(&value, data, sizeof(value));
+
+  return value;
+}
+
+static uint32_t xxh32Scalar(const unsigned char *data, size_t size)
+{
+  const unsigned char *ptr = data;
+  const unsigned char *end = data + size;
+
+  uint32_t hash = 0;
+
+  if (size >= 16)
+    {
+      uint32_t lanes[4] = {XXH_PRIME_1 + XXH_PRIME_2, XXH_PRIME_2, 0, 0u - XXH_PRIME_1};
+
+      for (; end - ptr >= 16; ptr += 16)
+        for (int i = 0; i < 4; ++i)
+          lanes[i] = rotateLeft(lanes[i] + load32(ptr + 4*i) * XXH_PRIME_2, 13) * XXH_PRIME_1;
+
+      hash = rotateLeft(lanes[0], 1) + rotateLeft(lanes[1], 7) +
+             rotateLeft(lanes[2], 12) + rotateLeft(lanes[3], 18);
+    }
+  else
+    hash = XXH_PRIME_5;
+
+  hash += (uint32_t)size;
+
+  return xxh32Finish(hash, ptr, (size_t)(end - ptr));
+}
+
+static uint32_t xxh32Finish(uint32_t hash, const unsigned char *data, size_t size)
+{
+  const unsigned char *end = data + size;
+
+  for (; end - data >= 4; data += 4)
+    hash = rotateLeft(hash + load32(data) * XXH_PRIME_3, 17) * XXH_PRIME_4;
+
+  for (; data != end; ++data)
+    hash = rotateLeft(hash + *data * XXH_PRIME_5, 11) * XXH_PRIME_1;
+
+  hash ^= hash >> 15;
+  hash *= XXH_PRIME_2;
+  hash ^= hash >> 13;
+  hash *= XXH_PRIME_3;
+  hash ^= hash >> 16;
+
+  return hash;
+}
+
+#ifdef HASH_X86_
+
+__attribute__((target("sse4.2")))
+static inline uint32_t crc32cSse42(const unsigned char *data, size_t size)
+{
+  uint64_t crc = ~0u;
+
+  size_t i = 0;
+
+  for (; i + 8 <= size; i += 8)
+    {
+      uint64_t value = 0;
+
+      memcpy(&value, data + i, sizeof(value));
+
+      crc = _mm_crc32_u64(crc, value);
+    }
+
+  uint32_t crc32 = (uint32_t)crc;
+
+  if (i + 4 <= size)
+    {
+      crc32 = _mm_crc32_u32(crc32, load32(data + i));
+
+      i += 4;
+    }
+
+  for (; i < size; ++i)
+    crc32 = _mm_crc32_u8(crc32, data[i]);
+
+  return ~crc32;
+}
+
+__attribute__((target("sse4.2")))
+static unsigned slotsCrc32cSse42(const unsigned char *array, size_t count, size_t elementSize, size_t firstIndex)
+{
+  unsigned hash = 0;
+
+  for (size_t i = 0; i < count; ++i, array += elementSize)
+    hash += placeHash(crc32cSse42(array, elementSize), firstIndex + i);
+
+  return hash;
+}
+
+__attribute__((target("sse4.1")))
+static uint32_t xxh32Sse41(const unsigned char *data, size_t size)
+{
+  if (size < 16)
+    return xxh32Scalar(data, size);
+
+  const unsigned char *ptr = data;
+  const unsigned char *end = data + size;
+
+  const __m128i prime1 = _mm_set1_epi32((int)XXH_PRIME_1);
+  const __m128i prime2 = _mm_set1_epi32((int)XXH_PRIME_2);
+
+  __m128i lanes = _mm_setr_epi32((int)(XXH_PRIME_1 + XXH_PRIME_2), (int)XXH_PRIME_2,
+                                 0, (int)(0u - XXH_PRIME_1));
+
+  for (; end - ptr >= 16; ptr += 16)
+    {
+      __m128i input = _mm_loadu_si128((const __m128i *)(const void *)ptr);
+
+      lanes = _mm_add_epi32(lanes, _mm_mullo_epi32(input, prime2));
+      lanes = _mm_or_si128(_mm_slli_epi32(lanes, 13), _mm_srli_epi32(lanes, 19));
+      lanes = _mm_mullo_epi32(lanes, prime1);
+    }
+
+  uint32_t lane[4] = {};
+
+  _mm_storeu_si128((__m128i *)(void *)lane, lanes);
+
+  uint32_t hash = rotateLeft(lane[0], 1) + rotateLeft(lane[1], 7) +
+                  rotateLeft(lane[2], 12) + rotateLeft(lane[3], 18);
+
+  hash += (uint32_t)size;
+
+  return xxh32Finish(hash, ptr, (size_t)(end - ptr));
+}
+
+#endif
@@ -0,0 +1,531 @@
+#include <stdlib.h>
+#include "lockfreestack.h"
+#include "systemlike.h"
+#include "logging.h"
+
+#pragma GCC diagnostic ignored "-Wcast-qual"
+#pragma GCC diagnostic ignored "-Wconditionally-supported"
+
+#ifndef RELEASE_BUILD_
+
+#define CHECK_VALID(STACK_POINTER, ERROR, ...)                          \
+  do                                                                    \
+    {                                                                   \
+      unsigned ERROR_CODE_TEMP = lockfree_valid(STACK_POINTER);         \
+                                                                        \
+      if (ERROR_CODE_TEMP)                                              \
+        {                                                               \
+          lockfree_dump(STACK_POINTER, ERROR_CODE_TEMP, getLogFile());  \
+                                                                        \
+          if (ERROR)                                                    \
+            *ERROR = ERROR_CODE_TEMP;                                   \
+                                                                        \
+          return __VA_ARGS__;                                           \
+        }                                                               \
+    } while (0)
+
+#else
+
+#define CHECK_VALID(STACK_POINTER, ERROR, ...)                          \
+  do                                                                    \
+    {                                                                   \
+      if (!STACK_POINTER)                                               \
+        {                                                               \
+          if (ERROR)                                                    \
+            *ERROR = NULL_STACK_POINTER;                                \
+                                                                        \
+          return __VA_ARGS__;                                           \
+        }                                                               \
+    } while (0)
+
+#endif
+
+const uint64_t INDEX_MASK = 0xFFFFFFFFu;
+const unsigned TAG_SHIFT  = 32;
+
+/// Make tagged head from node number and tag
+/// @param [in] number Index of node plus one or 0 for empty list
+/// @param [in] tag Counter of changes of head
+/// @return Tagged head
+static inline uint64_t makeHead(uint64_t number, uint64_t tag);
+
+/// Push node into list with tagged head
+/// @param [in/out] head Head of list
+/// @param [in] nodes Array of nodes
+/// @param [in] number Index of node plus one
+static void pushNode(std::atomic<uint64_t> *head, LockFreeNode *nodes, uint32_t number);
+
+/// Pop node from list with tagged head
+/// @param [in/out] head Head of list
+/// @param [in] nodes Array of nodes
+/// @return Index of node plus one or 0 if list is empty
+static uint32_t popNode(std::atomic<uint64_t> *head, LockFreeNode *nodes);
+
+/// Try to push node into list with tagged head with single CAS
+/// @param [in/out] head Head of list
+/// @param [in] nodes Array of nodes
+/// @param [in] number Index of node plus one
+/// @return Was node pushed
+static int tryPushNode(std::atomic<uint64_t> *head, LockFreeNode *nodes, uint32_t number);
+
+/// Try to pop node from list with tagged head with single CAS
+/// @param [in/out] head Head of list
+/// @param [in] nodes Array of nodes
+/// @param [out] number Index of node plus one or 0 if list is empty
+/// @return LOCKFREE_DONE if node was popped or list is empty, else LOCKFREE_CONTENTION
+static int tryPopNode(std::atomic<uint64_t> *head, LockFreeNode *nodes, uint32_t *number);
+
+unsigned lockfree_valid(const LockFreeStack *stk)
+{
+#ifdef RELEASE_BUILD_
+
+  return isPointerCorrect(stk) ? 0 : NULL_STACK_POINTER;
+
+#else
+
+  if (!isPointerCorrect(stk))
+    return NULL_STACK_POINTER;
+
+  unsigned error = 0;
+
+  if (!(stk->status & INIT) && (stk->status & DESTROY))
+    error |= DESTROY_WITHOUT_INIT;
+
+  int hasStorage = isPointerCorrect(stk->nodes);
+
+  if (!hasStorage && stk->capacity)
+    error |= NULL_ARRAY_POINTER;
+
+  if (stk->capacity < stk->size.load(std::memory_order_relaxed))
+    error |= CAPACITY_LESS_THAN_SIZE;
+
+  if (!isPointerCorrect((void *)stk->copyFunction))
+    error |= NOT_COPYFUNCTION;
+
+  if (stk->leftCanary != LEFT_CANARY)
+    error |= LEFT_CANARY_DIED;
+
+  if (stk->rightCanary != RIGHT_CANARY)
+    error |= RIGHT_CANARY_DIED;
+
+  if (hasStorage)
+    {
+      if (*(const CANARY *)((const char *)stk->nodes - sizeof(CANARY)) != LEFT_ARRAY_CANARY)
+        error |= LEFT_ARRAY_CANARY_DIED;
+
+      if (*(const CANARY *)(stk->nodes + stk->capacity) != RIGHT_ARRAY_CANARY)
+        error |= RIGHT_ARRAY_CANARY_DIED;
+    }
+
+  if (!isPointerCorrect(stk->info.name))
+    error |= NOT_NAME;
+
+  if (!isPointerCorrect(stk->info.fileName))
+    error |= NOT_FILE_NAME;
+
+  if (!isPointerCorrect(stk->info.functionName))
+    error |= NOT_FUNCTION_NAME;
+
+  if (stk->info.line <= 0)
+    error |= INCORRECT_LINE;
+
+  return error;
+
+#endif
+}
+
+void do_lockfree_init(LockFreeStack *stk, size_t capacity,
+                      void (*copyFunction)(Element *, const Element *),
+                      const char *name, const char *fileName, const char *functionName, int line,
+                      unsigned *error)
+{
+  if (!isPointerCorrect(stk) || !isPointerCorrect((void *)copyFunction) || !isPointerCorrect(name) || !isPointerCorrect(fileName) || !isPointerCorrect(functionName) || (line <= 0) || (stk->status & INIT) || !capacity || capacity >= INDEX_MASK)
+    {
+      if (isPointerCorrect(error))
+        *error = 1;
+
+      return;
+    }
+
+#ifndef RELEASE_BUILD_
+
+  stk->leftCanary  = LEFT_CANARY;
+  stk->rightCanary = RIGHT_CANARY;
+
+  stk->info.name         = name;
+  stk->info.fileName     = fileName;
+  stk->info.functionName = functionName;
+  stk->info.line         = line;
+
+  char *block = (char *) calloc(1, capacity*sizeof(LockFreeNode) + 2*sizeof(LockFreeNode));
+
+  if (!isPointerCorrect(block))
+    {
+      if (isPointerCorrect(error))
+        *error = 1;
+
+      return;
+    }
+
+  stk->nodes = (LockFreeNode *)(block + sizeof(LockFreeNode));
+
+  *(CANARY *)((char *)stk->nodes - sizeof(CANARY)) = LEFT_ARRAY_CANARY;
+  *(CANARY *)(stk->nodes + capacity)               = RIGHT_ARRAY_CANARY;
+
+#else
+
+  stk->nodes = (LockFreeNode *) calloc(capacity, sizeof(LockFreeNode));
+
+  if (!isPointerCorrect(stk->nodes))
+    {
+      if (isPointerCorrect(error))
+        *error = 1;
+
+      return;
+    }
+
+#endif
+
+  stk->capacity     = capacity;
+  stk->copyFunction = copyFunction;
+  stk->status       = INIT;
+
+  stk->size.store(0, std::memory_order_relaxed);
+  stk->top .store(0, std::memory_order_relaxed);
+
+  for (size_t i = 0; i < capacity - 1; ++i)
+    stk->nodes[i].next.store((uint32_t)(i + 2), std::memory_order_relaxed);
+
+  stk->nodes[capacity - 1].next.store(0, std::memory_order_relaxed);
+
+  stk->freeList.store(makeHead(1, 0), std::memory_order_release);
+
+  CHECK_VALID(stk, error);
+}
+
+void lockfree_destroy(LockFreeStack *stk, unsigned *error)
+{
+  CHECK_VALID(stk, error);
+
+  if (!(stk->status & INIT))
+    {
+      if (isPointerCorrect(error))
+        *error = 1;
+
+      return;
+    }
+
+#ifndef RELEASE_BUILD_
+
+  if (stk->nodes)
+    free((char *)stk->nodes - sizeof(LockFreeNode));
+
+#else
+
+  free(stk->nodes);
+
+#endif
+
+  stk->nodes    = nullptr;
+  stk->capacity = 0;
+
+  stk->top     .store(0, std::memory_order_relaxed);
+  stk->freeList.store(0, std::memory_order_relaxed);
+  stk->size    .store(0, std::memory_order_relaxed);
+
+  stk->copyFunction = nullptr;
+
+  stk->status |= DESTROY;
+}
+
+void lockfree_push(LockFreeStack *stk, const Element *element, unsigned *error)
+{
+  CHECK_VALID(stk, error);
+
+  if (!element)
+    {
+      if (error)
+        *error = 1;
+
+      return;
+    }
+
+  uint32_t number = popNode(&stk->freeList, stk->nodes);
+
+  if (!number)
+    {
+      if (error)
+        *error = 1;
+
+      return;
+    }
+
+  stk->copyFunction(&stk->nodes[number - 1].element, element);
+
+  stk->size.fetch_add(1, std::memory_order_relaxed);
+
+  pushNode(&stk->top, stk->nodes, number);
+}
+
+void lockfree_pop(LockFreeStack *stk, Element *element, unsigned *error)
+{
+  CHECK_VALID(stk, error);
+
+  if (!element)
+    {
+      if (error)
+        *error = 1;
+
+      return;
+    }
+
+  uint32_t number = popNode(&stk->top, stk->nodes);
+
+  if (!number)
+    {
+      if (error)
+        *error = 1;
+
+      return;
+    }
+
+  stk->size.fetch_sub(1, std::memory_order_relaxed);
+
+  stk->copyFunction(element, &stk->nodes[number - 1].element);
+
+  pushNode(&stk->freeList, stk->nodes, number);
+}
+
+int lockfree_tryPush(LockFreeStack *stk, const Element *element, unsigned *error)
+{
+  uint32_t number = lockfree_takeNode(stk, element, error);
+
+  if (!number)
+    return LOCKFREE_DONE;
+
+  if (lockfree_tryPushNode(stk, number))
+    return LOCKFREE_DONE;
+
+  lockfree_releaseNode(stk, number);
+
+  return LOCKFREE_CONTENTION;
+}
+
+int lockfree_tryPop(LockFreeStack *stk, Element *element, unsigned *error)
+{
+  CHECK_VALID(stk, error, LOCKFREE_DONE);
+
+  if (!element)
+    {
+      if (error)
+        *error = 1;
+
+      return LOCKFREE_DONE;
+    }
+
+  uint32_t number = 0;
+
+  if (!tryPopNode(&stk->top, stk->nodes, &number))
+    return LOCKFREE_CONTENTION;
+
+  if (!number)
+    {
+      if (error)
+        *error = 1;
+
+      return LOCKFREE_DONE;
+    }
+
+  stk->size.fetch_sub(1, std::memory_order_relaxed);
+
+  stk->copyFunction(element, &stk->nodes[number - 1].element);
+
+  pushNode(&stk->freeList, stk->nodes, number);
+
+  return LOCKFREE_DONE;
+}
+
+uint32_t lockfree_takeNode(LockFreeStack *stk, const Element *element, unsigned *error)
+{
+  CHECK_VALID(stk, error, 0);
+
+  if (!element)
+    {
+      if (error)
+        *error = 1;
+
+      return 0;
+    }
+
+  uint32_t number = popNode(&stk->freeList, stk->nodes);
+
+  if (!number)
+    {
+      if (error)
+        *error = 1;
+
+      return 0;
+    }
+
+  stk->copyFunction(&stk->nodes[number - 1].element, element);
+
+  stk->size.fetch_add(1, std::memory_order_relaxed);
+
+  return number;
+}
+
+int lockfree_tryPushNode(LockFreeStack *stk, uint32_t number)
+{
+  if (tryPushNode(&stk->top, stk->nodes, number))
+    return LOCKFREE_DONE;
+
+  return LOCKFREE_CONTENTION;
+}
+
+void lockfree_releaseNode(LockFreeStack *stk, uint32_t number)
+{
+  stk->size.fetch_sub(1, std::memory_order_relaxed);
+
+  pushNode(&stk->freeList, stk->nodes, number);
+}
+
+size_t lockfree_size(const LockFreeStack *stk, unsigned *error)
+{
+  CHECK_VALID(stk, error, -1u);
+
+  return stk->size.load(std::memory_order_relaxed);
+}
+
+int lockfree_isEmpty(const LockFreeStack *stk, unsigned *error)
+{
+  CHECK_VALID(stk, error, 0);
+
+  return !(stk->top.load(std::memory_order_acquire) & INDEX_MASK);
+}
+
+void do_lockfree_dump(const LockFreeStack *stk, unsigned errorCode, FILE *filePtr,
+                      const char *fileName, const char *functionName, int line)
+{
+#ifndef RELEASE_BUILD_
+
+  if (!isPointerCorrect(filePtr))
+    filePtr = stdout;
+
+  fputc('\n', filePtr);
+
+  fprintf(filePtr, "%s at %s (%d):\n",
+          isPointerCorrect(functionName) ? functionName : "nullptr",
+          isPointerCorrect(fileName)     ? fileName     : "nullptr",
+          line);
+  fprintf(filePtr, "LockFreeStack[%p]", (const void *)stk);
+
+  if (!isPointerCorrect(stk))
+    {
+      fputc('\n', filePtr);
+
+      printStackErrors(errorCode, filePtr);
+
+      return;
+    }
+
+  fprintf(filePtr, " \"%s\" at %s at %s (%d)\n",
+          isPointerCorrect(stk->info.name)         ? stk->info.name         : "nullptr",
+          isPointerCorrect(stk->info.functionName) ? stk->info.functionName : "nullptr",
+          isPointerCorrect(stk->info.fileName)     ? stk->info.fileName     : "nullptr",
+          stk->info.line);
+
+  printStackErrors(errorCode, filePtr);
+
+  uint64_t top      = stk->top     .load(std::memory_order_relaxed);
+  uint64_t freeList = stk->freeList.load(std::memory_order_relaxed);
+
+  fprintf(filePtr, "Nodes: %p Capacity: %lu Size: %lu\n",
+          (const void *)stk->nodes, stk->capacity, stk->size.load(std::memory_order_relaxed));
+  fprintf(filePtr, "Top: node %lu tag %lu Free list: node %lu tag %lu\n",
+          top & INDEX_MASK, top >> TAG_SHIFT, freeList & INDEX_MASK, freeList >> TAG_SHIFT);
+
+#else
+
+  (void)stk;
+  (void)errorCode;
+  (void)filePtr;
+  (void)fileName;
+  (void)functionName;
+  (void)line;
+
+#endif
+}
+
+static inline uint64_t makeHead(uint64_t number, uint64_t tag)
+{
+  return (tag << TAG_SHIFT) | (number & INDEX_MASK);
+}
+
+static void pushNode(std::atomic<uint64_t> *head, LockFreeNode *nodes, uint32_t number)
+{
+  uint64_t oldHead = head->load(std::memory_order_relaxed);
+  uint64_t newHead = 0;
+
+  do
+    {
+      nodes[number - 1].next.store((uint32_t)(oldHead & INDEX_MASK), std::memory_order_relaxed);
+
+      newHead = makeHead(number, (oldHead >> TAG_SHIFT) + 1);
+    }
+  while (!head->compare_exchange_weak(oldHead, newHead,
+                                      std::memory_order_release, std::memory_order_relaxed));
+}
+
+static uint32_t popNode(std::atomic<uint64_t> *head, LockFreeNode *nodes)
+{
+  uint64_t oldHead = head->load(std::memory_order_acquire);
+  uint64_t newHead = 0;
+
+  do
+    {
+      uint32_t number = (uint32_t)(oldHead & INDEX_MASK);
+
+      if (!number)
+        return 0;
+
+      uint32_t next = nodes[number - 1].next.load(std::memory_order_relaxed);
+
+      newHead = makeHead(next, (oldHead >> TAG_SHIFT) + 1);
+    }
+  while (!head->compare_exchange_weak(oldHead, newHead,
+                                      std::memory_order_acquire, std::memory_order_acquire));
+
+  return (uint32_t)(oldHead & INDEX_MASK);
+}
+
+static int tryPushNode(std::atomic<uint64_t> *head, LockFreeNode *nodes, uint32_t number)
+{
+  uint64_t oldHead = head->load(std::memory_order_relaxed);
+
+  nodes[number - 1].next.store((uint32_t)(oldHead & INDEX_MASK), std::memory_order_relaxed);
+
+  uint64_t newHead = makeHead(number, (oldHead >> TAG_SHIFT) + 1);
+
+  return head->compare_exchange_strong(oldHead, newHead,
+                                       std::memory_order_release, std::memory_order_relaxed);
+}
+
+static int tryPopNode(std::atomic<uint64_t> *head, LockFreeNode *nodes, uint32_t *number)
+{
+  uint64_t oldHead = head->load(std::memory_order_acquire);
+
+  *number = (uint32_t)(oldHead & INDEX_MASK);
+
+  if (!*number)
+    return LOCKFREE_DONE;
+
+  uint32_t next = nodes[*number - 1].next.load(std::memory_order_relaxed);
+
+  uint64_t newHead = makeHead(next, (oldHead >> TAG_SHIFT) + 1);
+
+  if (head->compare_exchange_strong(oldHead, newHead,
+                                    std::memory_order_acquire, std::memory_order_relaxed))
+    return LOCKFREE_DONE;
+
+  return LOCKFREE_CONTENTION;
+}
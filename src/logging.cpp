@@ -3,10 +3,25 @@
 #include <time.h>
 #include <string.h>
 #include <ctype.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <spawn.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
+#include <limits.h>
+#include <atomic>
+#include "conf.h"
 #include "logging.h"
 #include "systemlike.h"
 
+#ifdef BINARY_LOG_
+#define LOG_FILE_EXTENSION LOG_BINARY_FILE_SUFFIX
+#else
+#define LOG_FILE_EXTENSION LOG_FILE_SUFFIX
+#endif
+
 #define SEPARATOR "============================================="
 
 #define START_LOG                                               \
@@ -55,13 +70,134 @@ static unsigned initLog();
 /// @note Autocallable
 static void destroyLog();
 
-/// Try to open new file with name from getNewLogFileName() 
-/// @return Was file open
-/// @note Don`t auto close files
-static int openNewLogFile();
+/// Check if rotation policy says to open new file
+/// @return Is new file needed
+static int isRotationDue();
+
+/// Open new file with name from getNewLogFileName(), text after call goes to it
+/// @note Old file is closed by writer thread when it writes all text before call
+static void rotateLogFile();
+
+/// Open file for appending and start writer thread for it
+/// @param [in] name Name of file
+/// @return Stream which puts text into ring buffer or nullptr
+static FILE *openLogStream(const char *name);
+
+/// Write function of log stream, put text into ring buffer
+/// @param [in] cookie Unused
+/// @param [in] data Text
+/// @param [in] size Size of text
+/// @return size, text lost by overflow policy is counted as written
+static ssize_t logStreamWrite(void *cookie, const char *data, size_t size);
+
+/// Close function of log stream, write rest of ring buffer and stop writer thread
+/// @param [in] cookie Unused
+/// @return 0
+static int logStreamClose(void *cookie);
+
+/// Put text with prefix into ring buffer, so they follow each other in file
+/// @param [in] prefix Prefix, can be nullptr if prefixSize is 0
+/// @param [in] prefixSize Size of prefix
+/// @param [in] data Text
+/// @param [in] size Size of text, prefixSize + size isn`t bigger than LOG_BUFFER_SIZE
+/// @param [in] isNewFile Is text start of new file, it is never lost and its position is queued for writer
+/// @return Position of text in ring buffer or NO_POSITION if text is lost
+/// @note Many threads can put text at the same time without locks
+static size_t pushLog(const void *prefix, size_t prefixSize, const void *data, size_t size, int isNewFile = 0);
+
+#ifdef BINARY_LOG_
+
+/// Put record of binary log into ring buffer
+/// @param [in] type Type from LOG_RECORD
+/// @param [in] level Level from LogLevel
+/// @param [in] valueType Type from LOG_VALUE
+/// @param [in] start Start of body
+/// @param [in] startSize Size of start
+/// @param [in] data Rest of body
+/// @param [in] size Size of rest
+static void pushRecord(LOG_RECORD type, unsigned level, LOG_VALUE valueType,
+                       const void *start, size_t startSize, const void *data, size_t size);
+
+/// Write value to binary log
+/// @param [in] level Level of log`s print
+/// @param [in] valueType Type from LOG_VALUE
+/// @param [in] value Pointer to value
+/// @param [in] valueSize Size of value
+/// @param [in] name C-like string with value
+/// @param [in] fileName Name of file where was call function
+/// @param [in] functionName Name of function where was call function
+/// @param [in] line Number of line where was call function
+/// @return Size of record or -1 if site can`t be saved
+static int logBinary(unsigned level, LOG_VALUE valueType, const void *value, size_t valueSize,
+                     const char *name, const char *fileName, const char *functionName, int line);
+
+/// Get id of call site and write it to file if it isn`t written yet
+/// @param [in] name C-like string with value
+/// @param [in] fileName Name of file where was call function
+/// @param [in] functionName Name of function where was call function
+/// @param [in] line Number of line where was call function
+/// @return Id of site or LOG_SITES_COUNT if table of sites is full
+static uint32_t internSite(const char *name, const char *fileName, const char *functionName, int line);
+
+#endif
+
+/// Body of writer thread
+/// @param [in] arg Unused
+/// @return nullptr
+static void *logWriterLoop(void *arg);
+
+/// Write part of ring buffer to file
+/// @param [in] from Position of first byte
+/// @param [in] to Position after last byte
+static void writeRing(size_t from, size_t to);
+
+/// Close old file and continue with first pending file
+static void switchLogFile();
+
+/// Remember closed file for compression and mark files which policy doesn`t keep
+/// @param [in] name Name of closed file in heap
+static void finishClosedFile(char *name);
+
+/// Forget finished gzip processes, start waiting ones and delete files which policy doesn`t keep
+/// @return Count of running processes
+/// @note Never waits, file with running gzip is deleted by one of next calls
+static int reapCompressors();
+
+/// Write whole text to log file descriptor
+/// @param [in] data Text
+/// @param [in] size Size of text
+static void writeAll(const char *data, size_t size);
+
+/// Write count of lost bytes into log if it changed
+static void reportDropped();
+
+/// Read rules of call sites from LOG_SITES_ENV and LOG_CONTROL_FILE
+/// @note Call under LOG_SITES_LOCK
+static void loadLogRules();
+
+/// Check rules for call site
+/// @param [in] site Pointer to site
+/// @return LOG_SITE_ON or LOG_SITE_OFF
+static LOG_SITE_STATE checkLogRules(const LogSite *site);
+
+/// Check if pattern of rule matches call site
+/// @param [in] pattern Pattern, not C-like string
+/// @param [in] length Length of pattern
+/// @param [in] site Pointer to site
+/// @return Does pattern match site
+static int isRuleMatch(const char *pattern, size_t length, const LogSite *site);
+
+/// Check if LOG_CONTROL_FILE changed
+/// @param [in/out] lastChange Time of last change which was seen
+/// @return Did file change
+static int isControlFileChanged(timespec *lastChange);
+
+/// Sleep for some nanoseconds
+/// @param [in] nanoseconds Time of sleep
+static void logSleep(long nanoseconds);
 
 /// Return C-like string with data and time information
-/// @return C-like string in static array
+/// @return C-like string in static array of thread
 static const char *getDataString();
 
 /// Generate new log file name using LOG_FILE_PREFIX and LOG_FILE_SUFFIX
@@ -74,47 +210,119 @@ static unsigned LOG_LEVEL         = initLog();
 
 static char    *LOG_FILE_NAME     = nullptr;
 
-static size_t   MAX_LOG_FILE_SIZE = 1024 * 1024 * 256;
+const long LOG_WRITER_SLEEP_NS = 1000 * 1000;
 
-static unsigned initLog()
-{
-  if (!isFileExists(LOG_DIRECTORY))
-    mkdir(LOG_DIRECTORY, 0777);
+const long LOG_WAIT_SLEEP_NS   = 50 * 1000;
 
-  LOG_FILE_NAME = getNewLogFileName();
+// Positions in ring buffer only grow, byte of position is LOG_BUFFER[position % LOG_BUFFER_SIZE].
+// Producers reserve place by LogHead, copy text and then move LogCommitted in order of reservation.
+// Writer writes text until LogCommitted and moves LogTail
+static char                 *LOG_BUFFER = nullptr;
+static int                   LOG_FD     = -1;
+static pthread_t             LogWriter  = {};
 
-  LOG_FILE = fopen(LOG_FILE_NAME, "a");
+static std::atomic<size_t>   LogHead      {0};
+static std::atomic<size_t>   LogCommitted {0};
+static std::atomic<size_t>   LogTail      {0};
 
-  if (LOG_FILE == nullptr)
-    return 0x00;
+static std::atomic<int>      LogWriterRunning {0};
+static std::atomic<int>      LogOverflow      {LOG_OVERFLOW_BLOCK};
+static std::atomic<int>      LogPrecision     {TIMESTAMP_SECONDS};
 
-  setvbuf(LOG_FILE, nullptr, _IONBF, 0);
+static std::atomic<uint64_t> LogBytes         {0};
+static std::atomic<uint64_t> LogWrites        {0};
+static std::atomic<uint64_t> LogDroppedBytes  {0};
+static std::atomic<uint64_t> LogBlocks        {0};
 
-  atexit(destroyLog);
+static uint64_t              REPORTED_DROPPED = 0;
 
-  START_LOG;
+const size_t NO_POSITION = SIZE_MAX;
+
+const int LOG_COMPRESSORS_COUNT = 8;
 
-  unsigned level = 0;
+const size_t LOG_PENDING_FILES_COUNT = 8;
 
-#if   defined RELEASE_LOG_LEVEL_
+/// File opened by rotation, writer switches to it at its position
+typedef struct {
+  int   fd;
+  char *closedName; // Name of file which is closed at position
+} PendingFile;
 
-  level |= FATAL;
+// Thread which rotates opens new file and queues it, writer closes old file at position of new one.
+// Rotation number n is in slot n % LOG_PENDING_FILES_COUNT, first LogRotations of them are done.
+// Size of newest file is LogHead - LogFileStart, LogFileStart includes size of file at opening
+static pthread_mutex_t       LOG_ROTATION_LOCK = PTHREAD_MUTEX_INITIALIZER;
+static unsigned              LOG_FILE_NUMBER   = 0;
+static PendingFile           PENDING_FILES[LOG_PENDING_FILES_COUNT] = {};
 
-#elif defined ERROR_LOG_LEVEL_
+static std::atomic<size_t>   LogPendingAt[LOG_PENDING_FILES_COUNT];
+static std::atomic<uint64_t> LogRotationsQueued {0};
+static std::atomic<size_t>   LogFileStart      {0};
+static std::atomic<uint64_t> LogFileOpened     {0}; // Second of opening of newest file
+static std::atomic<uint64_t> LogRotations      {0};
 
-  level |= FATAL | ERROR;
+static std::atomic<int>      LogRotationMode   {LOG_ROTATION_SIZE};
+static std::atomic<size_t>   LogMaxFileSize    {DEFAULT_MAX_LOG_FILE_SIZE};
+static std::atomic<unsigned> LogFileSeconds    {DEFAULT_LOG_FILE_SECONDS};
+static std::atomic<unsigned> LogKeepFiles      {0};
+static std::atomic<int>      LogCompress       {0};
 
-#elif defined MESSAGE_LOG_LEVEL_
+/// File closed by rotation
+typedef struct {
+  char  *name;
+  pid_t  compressor; // Running gzip process or 0
+  int    compress;   // gzip waits for place among LOG_COMPRESSORS_COUNT processes
+  int    remove;     // Policy doesn`t keep file, it is deleted when its gzip finishes
+} ClosedFile;
 
-  level |= FATAL | ERROR | MESSAGE;
+// Only writer thread uses closed files
+static ClosedFile           *CLOSED_FILES       = nullptr;
+static size_t                CLOSED_FILES_COUNT = 0;
 
-#elif defined VALUE_LOG_LEVEL_
+const uint64_t LOG_CONTROL_CHECK_NS = 1000 * 1000 * 1000;
 
-  level |= FATAL | ERROR | MESSAGE | VALUE;
+static pthread_mutex_t       LOG_SITES_LOCK   = PTHREAD_MUTEX_INITIALIZER;
+static LogSite              *LOG_SITES        = nullptr; // List of registered sites
+static char                 *LOG_RULES        = nullptr;
+static int                   LOG_RULES_LOADED = 0;
+
+#ifdef BINARY_LOG_
+
+/// Call site of log function in binary log
+typedef struct {
+  const char *name;
+  const char *fileName;
+  const char *functionName;
+  int         line;
+  unsigned    generation; // Generation of file where site is written
+} BinarySite;
+
+const size_t MAX_RECORD_START = sizeof(LogValueRecord) + sizeof(double);
+
+// Sites are found by addresses of their strings, strings of LogSite are literals
+static pthread_mutex_t       BINARY_SITES_LOCK = PTHREAD_MUTEX_INITIALIZER;
+static BinarySite           *BINARY_SITES      = nullptr;
+static unsigned              LOG_GENERATION    = 0;
 
 #endif
 
-  return level;
+static unsigned initLog()
+{
+  if (!isFileExists(LOG_DIRECTORY))
+    mkdir(LOG_DIRECTORY, 0777);
+
+  LOG_FILE_NAME = getNewLogFileName();
+
+  LOG_FILE = openLogStream(LOG_FILE_NAME);
+
+  if (LOG_FILE == nullptr)
+    return 0x00;
+
+  atexit(destroyLog);
+
+  START_LOG;
+
+  return STATIC_LOG_LEVEL;
 }
 
 static void destroyLog()
@@ -138,39 +346,101 @@ static void destroyLog()
 
 FILE *getLogFile()
 {
-  int isNameCorrect = isPointerCorrect(LOG_FILE_NAME);
+  if (LOG_FILE && isRotationDue())
+    rotateLogFile();
 
-  int isFileFull    = getFileSize(LOG_FILE_NAME) >= MAX_LOG_FILE_SIZE;
+  return LOG_FILE;
+}
 
-  if (isNameCorrect && isFileFull)
-    {
-      if (isPointerCorrect(LOG_FILE))
-        {
-          NEW_LOG_FILE;
+static int isRotationDue()
+{
+  if (LogRotationMode.load(std::memory_order_relaxed) == LOG_ROTATION_TIME)
+    return getTimestamp(TIMESTAMP_SECONDS) / 1000000000u >=
+           LogFileOpened.load(std::memory_order_relaxed) + LogFileSeconds.load(std::memory_order_relaxed);
 
-          fclose(LOG_FILE);
-        }
+  return LogHead.load(std::memory_order_relaxed) - LogFileStart.load(std::memory_order_relaxed) >=
+         LogMaxFileSize.load(std::memory_order_relaxed);
+}
 
-      free(LOG_FILE_NAME);
+static void rotateLogFile()
+{
+  pthread_mutex_lock(&LOG_ROTATION_LOCK);
 
-      if (!openNewLogFile())
-        return nullptr;
+  if (!isRotationDue())
+    {
+      pthread_mutex_unlock(&LOG_ROTATION_LOCK);
 
-      NEW_LOG_FILE;
+      return;
     }
-  else if (!isNameCorrect && isFileFull)
+
+  // Writer is too far behind, it frees slot when it switches to next file
+  while (LogRotationsQueued.load(std::memory_order_relaxed) - LogRotations.load(std::memory_order_acquire) >=
+         LOG_PENDING_FILES_COUNT)
+    logSleep(LOG_WAIT_SLEEP_NS);
+
+  uint64_t now  = getTimestamp(TIMESTAMP_SECONDS) / 1000000000u;
+
+  char    *name = getNewLogFileName();
+
+  int      fd   = open(name, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0666);
+
+  if (fd < 0)
     {
-      if (!openNewLogFile())
-        return nullptr;
+      free(name);
+
+      // Next try is after one more period
+      LogFileStart.store(LogHead.load());
+      LogFileOpened.store(now);
 
-      NEW_LOG_FILE;
+      pthread_mutex_unlock(&LOG_ROTATION_LOCK);
+
+      return;
     }
 
-  return LOG_FILE;
+  NEW_LOG_FILE;
+
+  fflush(LOG_FILE);
+
+  struct stat status = {};
+
+  fstat(fd, &status);
+
+  PendingFile *pending = PENDING_FILES + LogRotationsQueued.load(std::memory_order_relaxed) % LOG_PENDING_FILES_COUNT;
+
+  pending->fd         = fd;
+  pending->closedName = LOG_FILE_NAME;
+
+  LOG_FILE_NAME = name;
+
+#ifdef BINARY_LOG_
+
+  // Sites written after start of file belong to new generation
+  pthread_mutex_lock(&BINARY_SITES_LOCK);
+
+  size_t position = pushLog(nullptr, 0, LOG_BINARY_MAGIC, sizeof(LOG_BINARY_MAGIC) - 1, 1);
+
+  ++LOG_GENERATION;
+
+  pthread_mutex_unlock(&BINARY_SITES_LOCK);
+
+#else
+
+  size_t position = pushLog(nullptr, 0, nullptr, 0, 1);
+
+#endif
+
+  LogFileStart.store(position - (size_t) status.st_size);
+  LogFileOpened.store(now);
+
+  NEW_LOG_FILE;
+
+  pthread_mutex_unlock(&LOG_ROTATION_LOCK);
 }
 
 char *getNewLogFileName()
 {
+  unsigned number = LOG_FILE_NUMBER++;
+
   time_t now = 0;
   time(&now);
   char *dataString = ctime(&now);
@@ -182,8 +452,8 @@ char *getNewLogFileName()
   size_t size =
     sizeof(LOG_DIRECTORY)   +
     sizeof(LOG_FILE_PREFIX) +
-    sizeof(LOG_FILE_SUFFIX) +
-    strlen(dataString)      + 3;
+    sizeof(LOG_FILE_EXTENSION) +
+    strlen(dataString)      + 3 + 12;
 
   char *newLogFileName = (char *) calloc(1, size);
 
@@ -193,9 +463,15 @@ char *getNewLogFileName()
   strcat (newLogFileName, LOG_DIRECTORY);
   strcat (newLogFileName, LOG_FILE_PREFIX);
   strcat (newLogFileName, "_");
-  strncat(newLogFileName, dataString, strlen(dataString) - 1);
+  // Date string ends with '\n', it isn`t copied
+  memcpy(newLogFileName + strlen(newLogFileName), dataString, strlen(dataString) - 1);
+
+  // Files opened in one second differ by number
+  if (number)
+    sprintf(newLogFileName + strlen(newLogFileName), "_%u", number);
+
   strcat (newLogFileName, ".");
-  strcat (newLogFileName, LOG_FILE_SUFFIX);
+  strcat (newLogFileName, LOG_FILE_EXTENSION);
 
   return newLogFileName;
 }
@@ -209,6 +485,9 @@ int loggingPrint(unsigned level, long long value, const char *name,
 
 #endif
 
+  if (!(LOG_LEVEL & level))
+    return 0;
+
   if (!isPointerCorrect(name))
     name         = "nullptr";
   if (!isPointerCorrect(fileName))
@@ -216,14 +495,20 @@ int loggingPrint(unsigned level, long long value, const char *name,
   if (!isPointerCorrect(functionName))
     functionName = "nullptr";
 
-  if (!(LOG_LEVEL & level))
-    return 0;
-
   FILE *filePtr = getLogFile();
 
   if (!isPointerCorrect(filePtr))
     return 0;
 
+#ifdef BINARY_LOG_
+
+  int size = logBinary(level, LOG_VALUE_LONG_LONG, &value, sizeof(value), name, fileName, functionName, line);
+
+  if (size >= 0)
+    return size;
+
+#endif
+
   const char *dataString = getDataString();
 
   if (!isPointerCorrect(dataString))
@@ -257,6 +542,9 @@ int loggingPrint(unsigned level, double value, const char *name,
 
 #endif
 
+  if (!(LOG_LEVEL & level))
+    return 0;
+
   if (!isPointerCorrect(name))
     name         = "nullptr";
   if (!isPointerCorrect(fileName))
@@ -264,14 +552,20 @@ int loggingPrint(unsigned level, double value, const char *name,
   if (!isPointerCorrect(functionName))
     functionName = "nullptr";
 
-  if (!(LOG_LEVEL & level))
-    return 0;
-
   FILE *filePtr = getLogFile();
 
   if (!isPointerCorrect(filePtr))
     return 0;
 
+#ifdef BINARY_LOG_
+
+  int size = logBinary(level, LOG_VALUE_DOUBLE, &value, sizeof(value), name, fileName, functionName, line);
+
+  if (size >= 0)
+    return size;
+
+#endif
+
   const char *dataString = getDataString();
 
   if (!isPointerCorrect(dataString))
@@ -303,6 +597,10 @@ int loggingPrint(unsigned level, char value, const char *name,
   return 0;
 
 #endif
+
+  if (!(LOG_LEVEL & level))
+    return 0;
+
   value = isgraph(value) ? value : isspace(value) ? ' ' : '#';
 
   if (!isPointerCorrect(name))
@@ -312,14 +610,20 @@ int loggingPrint(unsigned level, char value, const char *name,
   if (!isPointerCorrect(functionName))
     functionName = "nullptr";
 
-  if (!(LOG_LEVEL & level))
-    return 0;
-
   FILE *filePtr = getLogFile();
 
   if (!isPointerCorrect(filePtr))
     return 0;
 
+#ifdef BINARY_LOG_
+
+  int size = logBinary(level, LOG_VALUE_CHAR, &value, sizeof(value), name, fileName, functionName, line);
+
+  if (size >= 0)
+    return size;
+
+#endif
+
   const char *dataString = getDataString();
 
   if (!isPointerCorrect(dataString))
@@ -352,6 +656,9 @@ int loggingPrint(unsigned level, const void *value, const char *name,
 
 #endif
 
+  if (!(LOG_LEVEL & level))
+    return 0;
+
   if (!isPointerCorrect(name))
     name         = "nullptr";
   if (!isPointerCorrect(fileName))
@@ -359,14 +666,22 @@ int loggingPrint(unsigned level, const void *value, const char *name,
   if (!isPointerCorrect(functionName))
     functionName = "nullptr";
 
-  if (!(LOG_LEVEL & level))
-    return 0;
-
   FILE *filePtr = getLogFile();
 
   if (!isPointerCorrect(filePtr))
     return 0;
 
+#ifdef BINARY_LOG_
+
+  uint64_t address = (uintptr_t) value;
+
+  int size = logBinary(level, LOG_VALUE_POINTER, &address, sizeof(address), name, fileName, functionName, line);
+
+  if (size >= 0)
+    return size;
+
+#endif
+
   const char *dataString = getDataString();
 
   if (!isPointerCorrect(dataString))
@@ -393,6 +708,9 @@ int loggingPrint(unsigned level, const void *value, const char *name,
 int loggingPrint(unsigned level, const char *value, const char *name,
                  const char *fileName, const char *functionName, int line)
 {
+  if (!(LOG_LEVEL & level))
+    return 0;
+
   if (!isPointerCorrect(value))
     value        = "nullptr";
   if (!isPointerCorrect(name))
@@ -402,14 +720,20 @@ int loggingPrint(unsigned level, const char *value, const char *name,
   if (!isPointerCorrect(functionName))
     functionName = "nullptr";
 
-  if (!(LOG_LEVEL & level))
-    return 0;
-
   FILE *filePtr = getLogFile();
 
   if (!isPointerCorrect(filePtr))
     return 0;
 
+#ifdef BINARY_LOG_
+
+  int size = logBinary(level, LOG_VALUE_STRING, value, strlen(value), name, fileName, functionName, line);
+
+  if (size >= 0)
+    return size;
+
+#endif
+
   const char *dataString = getDataString();
 
   if (!isPointerCorrect(dataString))
@@ -434,8 +758,15 @@ int loggingPrint(unsigned level, const char *value, const char *name,
                      dataString, fileName, functionName, line, value);
 
     case FATAL:
-      return fprintf(filePtr, "[%s] File: %30s, Function: %60s, Line: %5d. !!FATAL ERROR!!: \"%s\".",
-                     dataString, fileName, functionName, line, value);
+      {
+        int count = fprintf(filePtr, "[%s] File: %30s, Function: %60s, Line: %5d. !!FATAL ERROR!!: \"%s\".",
+                            dataString, fileName, functionName, line, value);
+
+        // Program can crash right after fatal error
+        flushLog();
+
+        return count;
+      }
 
     default:
       return fprintf(filePtr, "Incorrect use of log functions!! File: %30s, Function: %60s, Line %5d.",
@@ -445,35 +776,757 @@ int loggingPrint(unsigned level, const char *value, const char *name,
     }
 }
 
-static int openNewLogFile()
+static FILE *openLogStream(const char *name)
 {
-  LOG_FILE_NAME = getNewLogFileName();
+  LOG_FD = open(name, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0666);
+
+  if (LOG_FD < 0)
+    return nullptr;
+
+  LOG_BUFFER = (char *) malloc(LOG_BUFFER_SIZE);
+
+  struct stat status = {};
 
-  LOG_FILE = fopen(LOG_FILE_NAME, "a");
+  fstat(LOG_FD, &status);
 
-  if (!isPointerCorrect(LOG_FILE))
+  LogHead.store(0);
+  LogCommitted.store(0);
+  LogTail.store(0);
+
+  LogFileStart.store(0 - (size_t) status.st_size);
+  LogFileOpened.store(getTimestamp(TIMESTAMP_SECONDS) / 1000000000u);
+
+  LogWriterRunning.store(1);
+
+  if (!LOG_BUFFER || pthread_create(&LogWriter, nullptr, logWriterLoop, nullptr))
     {
-      LOG_LEVEL = 0x00;
+      LogWriterRunning.store(0);
 
-      return 0;
+      free(LOG_BUFFER);
+      close(LOG_FD);
+
+      LOG_BUFFER = nullptr;
+      LOG_FD     = -1;
+
+      return nullptr;
     }
 
-  setvbuf(LOG_FILE, nullptr, _IONBF, 0);
+  cookie_io_functions_t functions = {nullptr, logStreamWrite, nullptr, logStreamClose};
+
+  FILE *stream = fopencookie(nullptr, "a", functions);
+
+  if (!stream)
+    {
+      logStreamClose(nullptr);
+
+      return nullptr;
+    }
 
-  return 1;
+#ifdef BINARY_LOG_
+
+  // Each part of text becomes record, so text is collected by lines.
+  // Sites are written again to new file
+  setvbuf(stream, nullptr, _IOLBF, BUFSIZ);
+
+  pthread_mutex_lock(&BINARY_SITES_LOCK);
+
+  ++LOG_GENERATION;
+
+  pthread_mutex_unlock(&BINARY_SITES_LOCK);
+
+  pushLog(nullptr, 0, LOG_BINARY_MAGIC, sizeof(LOG_BINARY_MAGIC) - 1, 0);
+
+#else
+
+  // Each print goes to ring buffer at once, it is cheap without syscall
+  setvbuf(stream, nullptr, _IONBF, 0);
+
+#endif
+
+  return stream;
 }
 
-static const char *getDataString()
+static ssize_t logStreamWrite(void *, const char *data, size_t size)
 {
-  time_t now = 0;
+  for (size_t written = 0; written < size; )
+    {
+      size_t part = size - written < LOG_BUFFER_SIZE / 2 ? size - written : LOG_BUFFER_SIZE / 2;
 
-  time(&now);
+#ifdef BINARY_LOG_
 
-  char *dataString = ctime(&now);
+      pushRecord(LOG_RECORD_TEXT, 0, LOG_VALUE_STRING, nullptr, 0, data + written, part);
+
+#else
+
+      pushLog(nullptr, 0, data + written, part);
+
+#endif
+
+      written += part;
+    }
+
+  return (ssize_t) size;
+}
+
+static int logStreamClose(void *)
+{
+  LogWriterRunning.store(0);
+
+  pthread_join(LogWriter, nullptr);
+
+  close(LOG_FD);
+  free(LOG_BUFFER);
+
+  LOG_FD     = -1;
+  LOG_BUFFER = nullptr;
+
+  // Closed files are compressed and deleted by policy before exit
+  while (reapCompressors())
+    logSleep(LOG_WRITER_SLEEP_NS);
+
+  for (size_t i = 0; i < CLOSED_FILES_COUNT; ++i)
+    free(CLOSED_FILES[i].name);
+
+  free(CLOSED_FILES);
+
+  CLOSED_FILES       = nullptr;
+  CLOSED_FILES_COUNT = 0;
+
+  return 0;
+}
+
+static size_t pushLog(const void *prefix, size_t prefixSize, const void *data, size_t size, int isNewFile)
+{
+  size_t textSize = size;
+
+  size += prefixSize;
+
+  size_t head    = LogHead.load(std::memory_order_relaxed);
+  int    waited  = 0;
+
+  for (;;)
+    {
+      if (head + size - LogTail.load(std::memory_order_acquire) > LOG_BUFFER_SIZE)
+        {
+          if (!isNewFile && LogOverflow.load(std::memory_order_relaxed) != LOG_OVERFLOW_BLOCK)
+            {
+              LogDroppedBytes.fetch_add(size, std::memory_order_relaxed);
+
+              return NO_POSITION;
+            }
+
+          if (!waited)
+            LogBlocks.fetch_add(1, std::memory_order_relaxed);
+
+          waited = 1;
+
+          logSleep(LOG_WAIT_SLEEP_NS);
+
+          head = LogHead.load(std::memory_order_relaxed);
+
+          continue;
+        }
+
+      if (LogHead.compare_exchange_weak(head, head + size, std::memory_order_relaxed))
+        break;
+    }
+
+  size_t index = head % LOG_BUFFER_SIZE;
+
+  for (int part = 0; part < 2; ++part)
+    {
+      const char *from   = part ? (const char *) data : (const char *) prefix;
+      size_t      length = part ? textSize            : prefixSize;
+
+      size_t first = length < LOG_BUFFER_SIZE - index ? length : LOG_BUFFER_SIZE - index;
+
+      memcpy(LOG_BUFFER + index, from, first);
+      memcpy(LOG_BUFFER, from + first, length - first);
+
+      index = (index + length) % LOG_BUFFER_SIZE;
+    }
+
+  // Writer can`t pass head before commit, so it sees new file in time
+  if (isNewFile)
+    {
+      uint64_t queued = LogRotationsQueued.load(std::memory_order_relaxed);
+
+      LogPendingAt[queued % LOG_PENDING_FILES_COUNT].store(head, std::memory_order_relaxed);
+
+      LogRotationsQueued.store(queued + 1, std::memory_order_release);
+    }
+
+  // Text before head can be still copied by other threads
+  while (LogCommitted.load(std::memory_order_acquire) != head)
+    sched_yield();
+
+  LogCommitted.store(head + size, std::memory_order_release);
+
+  return head;
+}
+
+#ifdef BINARY_LOG_
+
+static void pushRecord(LOG_RECORD type, unsigned level, LOG_VALUE valueType,
+                       const void *start, size_t startSize, const void *data, size_t size)
+{
+  if (startSize > MAX_RECORD_START)
+    return;
+
+  // Header and start are joined in one prefix
+  char prefix[sizeof(LogRecordHeader) + MAX_RECORD_START] = {};
+
+  LogRecordHeader header = {(uint8_t) type, (uint8_t) level, (uint8_t) valueType, 0, (uint32_t) (startSize + size)};
+
+  memcpy(prefix, &header, sizeof(header));
+
+  if (startSize)
+    memcpy(prefix + sizeof(header), start, startSize);
+
+  pushLog(prefix, sizeof(header) + startSize, data, size);
+}
+
+static int logBinary(unsigned level, LOG_VALUE valueType, const void *value, size_t valueSize,
+                     const char *name, const char *fileName, const char *functionName, int line)
+{
+  uint32_t site = internSite(name, fileName, functionName, line);
+
+  if (site == LOG_SITES_COUNT)
+    return -1;
+
+  if (valueSize > LOG_BUFFER_SIZE / 2)
+    valueSize = LOG_BUFFER_SIZE / 2;
+
+  LogValueRecord record = {getTimestamp((TIMESTAMP_PRECISION) LogPrecision.load(std::memory_order_relaxed)), site};
+
+  // Text of dumps printed before must be before record
+  fflush(LOG_FILE);
+
+  if (valueType == LOG_VALUE_STRING)
+    pushRecord(LOG_RECORD_VALUE, level, valueType, &record, sizeof(record), value, valueSize);
+  else
+    {
+      char start[MAX_RECORD_START] = {};
+
+      memcpy(start, &record, sizeof(record));
+      memcpy(start + sizeof(record), value, valueSize);
+
+      pushRecord(LOG_RECORD_VALUE, level, valueType, start, sizeof(record) + valueSize, nullptr, 0);
+    }
+
+  // Program can crash right after fatal error
+  if (level == FATAL)
+    flushLog();
+
+  return (int) (sizeof(LogRecordHeader) + sizeof(record) + valueSize);
+}
+
+static uint32_t internSite(const char *name, const char *fileName, const char *functionName, int line)
+{
+  pthread_mutex_lock(&BINARY_SITES_LOCK);
+
+  if (!BINARY_SITES)
+    BINARY_SITES = (BinarySite *) calloc(LOG_SITES_COUNT, sizeof(BinarySite));
+
+  if (!BINARY_SITES)
+    {
+      pthread_mutex_unlock(&BINARY_SITES_LOCK);
+
+      return LOG_SITES_COUNT;
+    }
+
+  uint32_t hash = (uint32_t) (((uintptr_t) name ^ (uintptr_t) fileName * 31 ^ (uintptr_t) functionName * 17) >> 3) ^
+                  (uint32_t) line * 2654435761u;
+
+  uint32_t site = hash % LOG_SITES_COUNT;
+
+  for (uint32_t probe = 0; probe < LOG_SITES_COUNT; ++probe, site = (site + 1) % LOG_SITES_COUNT)
+    {
+      BinarySite *entry = BINARY_SITES + site;
+
+      if (!entry->name)
+        {
+          entry->name         = name;
+          entry->fileName     = fileName;
+          entry->functionName = functionName;
+          entry->line         = line;
+        }
+      else if (entry->name != name || entry->fileName != fileName ||
+               entry->functionName != functionName || entry->line != line)
+        continue;
+
+      if (entry->generation != LOG_GENERATION)
+        {
+          size_t nameSize     = strlen(name)         + 1;
+          size_t fileSize     = strlen(fileName)     + 1;
+          size_t functionSize = strlen(functionName) + 1;
+
+          char *strings = (char *) malloc(nameSize + fileSize + functionSize);
+
+          if (!strings)
+            break;
+
+          memcpy(strings,                       name,         nameSize);
+          memcpy(strings + nameSize,            fileName,     fileSize);
+          memcpy(strings + nameSize + fileSize, functionName, functionSize);
+
+          LogSiteRecord record = {site, line};
+
+          // Site is written under lock, so nobody writes its value before it
+          fflush(LOG_FILE);
+
+          pushRecord(LOG_RECORD_SITE, 0, LOG_VALUE_STRING, &record, sizeof(record),
+                     strings, nameSize + fileSize + functionSize);
+
+          free(strings);
+
+          entry->generation = LOG_GENERATION;
+        }
+
+      pthread_mutex_unlock(&BINARY_SITES_LOCK);
+
+      return site;
+    }
+
+  pthread_mutex_unlock(&BINARY_SITES_LOCK);
+
+  return LOG_SITES_COUNT;
+}
+
+#endif
+
+static void *logWriterLoop(void *)
+{
+  timespec controlChange = {};
+  timespec lastCheck     = {};
+
+  for (;;)
+    {
+      timespec now = {};
+
+      clock_gettime(CLOCK_MONOTONIC, &now);
+
+      if ((uint64_t) (now.tv_sec - lastCheck.tv_sec) * 1000000000u + (uint64_t) now.tv_nsec -
+          (uint64_t) lastCheck.tv_nsec >= LOG_CONTROL_CHECK_NS)
+        {
+          lastCheck = now;
+
+          if (isControlFileChanged(&controlChange))
+            reloadLogSites();
+        }
+
+      // New file is queued before its commit, so it is seen if committed text is after it
+      int      running   = LogWriterRunning.load();
+      size_t   committed = LogCommitted.load(std::memory_order_acquire);
+      size_t   tail      = LogTail.load(std::memory_order_relaxed);
+      uint64_t rotations = LogRotations.load(std::memory_order_relaxed);
+      size_t   rotateAt  = LogRotationsQueued.load(std::memory_order_acquire) != rotations ?
+                           LogPendingAt[rotations % LOG_PENDING_FILES_COUNT].load(std::memory_order_relaxed) :
+                           NO_POSITION;
+
+      if (rotateAt != NO_POSITION && committed >= rotateAt)
+        {
+          writeRing(tail, rotateAt);
+
+          LogTail.store(rotateAt, std::memory_order_release);
+
+          switchLogFile();
+
+          continue;
+        }
+
+      if (committed != tail)
+        {
+          writeRing(tail, committed);
+
+          LogTail.store(committed, std::memory_order_release);
+        }
+      else if (!running)
+        break;
+      else
+        logSleep(LOG_WRITER_SLEEP_NS);
+
+      reportDropped();
+
+      reapCompressors();
+    }
+
+  return nullptr;
+}
+
+static void switchLogFile()
+{
+  uint64_t     rotations = LogRotations.load(std::memory_order_relaxed);
+  PendingFile *pending   = PENDING_FILES + rotations % LOG_PENDING_FILES_COUNT;
+
+  close(LOG_FD);
+
+  LOG_FD = pending->fd;
+
+  char *closed = pending->closedName;
+
+  pending->fd         = -1;
+  pending->closedName = nullptr;
+
+  // Slot can be taken by next rotation
+  LogRotations.store(rotations + 1, std::memory_order_release);
+
+  finishClosedFile(closed);
+}
+
+static void finishClosedFile(char *name)
+{
+  if (!name)
+    return;
+
+  ClosedFile *files = (ClosedFile *) realloc(CLOSED_FILES, (CLOSED_FILES_COUNT + 1) * sizeof(ClosedFile));
+
+  if (!files)
+    {
+      free(name);
+
+      return;
+    }
+
+  CLOSED_FILES = files;
+
+  CLOSED_FILES[CLOSED_FILES_COUNT++] = {name, 0, LogCompress.load(), 0};
+
+  size_t keep = LogKeepFiles.load();
+
+  if (keep)
+    {
+      size_t kept = 0;
+
+      // Newest files are kept
+      for (size_t i = CLOSED_FILES_COUNT; i-- > 0; )
+        if (!CLOSED_FILES[i].remove && ++kept > keep)
+          CLOSED_FILES[i].remove = 1;
+    }
+
+  reapCompressors();
+}
+
+static int reapCompressors()
+{
+  int running = 0;
+
+  for (size_t i = 0; i < CLOSED_FILES_COUNT; ++i)
+    {
+      ClosedFile *file = CLOSED_FILES + i;
+
+      if (file->compressor && waitpid(file->compressor, nullptr, WNOHANG))
+        file->compressor = 0;
+
+      if (file->compressor)
+        ++running;
+    }
+
+  size_t count = 0;
+
+  for (size_t i = 0; i < CLOSED_FILES_COUNT; ++i)
+    {
+      ClosedFile *file = CLOSED_FILES + i;
+
+      if (file->compress && !file->remove && running < LOG_COMPRESSORS_COUNT)
+        {
+          char  gzip[]  = "gzip";
+          char  force[] = "-f";
+          char *argv[]  = {gzip, force, file->name, nullptr};
+
+          if (posix_spawnp(&file->compressor, gzip, nullptr, nullptr, argv, environ))
+            file->compressor = 0;
+          else
+            ++running;
+
+          file->compress = 0;
+        }
+
+      // File can be deleted only when gzip finished with it
+      if (file->remove && !file->compressor)
+        {
+          char compressed[PATH_MAX] = "";
+
+          snprintf(compressed, sizeof(compressed), "%s.gz", file->name);
+
+          unlink(file->name);
+          unlink(compressed);
+
+          free(file->name);
+
+          continue;
+        }
+
+      // All files are kept, so only files with gzip are remembered
+      if (!LogKeepFiles.load() && !file->compressor && !file->compress)
+        {
+          free(file->name);
+
+          continue;
+        }
+
+      CLOSED_FILES[count++] = *file;
+    }
+
+  CLOSED_FILES_COUNT = count;
+
+  return running;
+}
+
+static void writeRing(size_t from, size_t to)
+{
+  size_t index = from % LOG_BUFFER_SIZE;
+  size_t size  = to - from;
+  size_t first = size < LOG_BUFFER_SIZE - index ? size : LOG_BUFFER_SIZE - index;
+
+  writeAll(LOG_BUFFER + index, first);
+  writeAll(LOG_BUFFER, size - first);
+}
+
+static void writeAll(const char *data, size_t size)
+{
+  while (size)
+    {
+      ssize_t written = write(LOG_FD, data, size);
+
+      if (written < 0 && errno == EINTR)
+        continue;
+
+      if (written <= 0)
+        return;
+
+      LogWrites.fetch_add(1, std::memory_order_relaxed);
+      LogBytes.fetch_add((uint64_t) written, std::memory_order_relaxed);
+
+      data += written;
+      size -= (size_t) written;
+    }
+}
+
+static void reportDropped()
+{
+  uint64_t dropped = LogDroppedBytes.load(std::memory_order_relaxed);
+
+  if (dropped == REPORTED_DROPPED || LogOverflow.load(std::memory_order_relaxed) != LOG_OVERFLOW_COUNT)
+    return;
+
+  char message[256] = "";
+
+  int length = snprintf(message, sizeof(message), "\n" SEPARATOR " %llu BYTES OF LOG WERE LOST " SEPARATOR "\n",
+                        (unsigned long long) (dropped - REPORTED_DROPPED));
+
+  if (length > 0)
+    writeAll(message, (size_t) length < sizeof(message) ? (size_t) length : sizeof(message) - 1);
+
+  REPORTED_DROPPED = dropped;
+}
+
+static void logSleep(long nanoseconds)
+{
+  timespec time = {0, nanoseconds};
+
+  nanosleep(&time, nullptr);
+}
+
+int isLogSiteOn(LogSite *site)
+{
+  int state = site->state.load(std::memory_order_acquire);
+
+  if (state != LOG_SITE_UNKNOWN)
+    return state == LOG_SITE_ON;
+
+  pthread_mutex_lock(&LOG_SITES_LOCK);
+
+  state = site->state.load(std::memory_order_relaxed);
+
+  if (state == LOG_SITE_UNKNOWN)
+    {
+      if (!LOG_RULES_LOADED)
+        loadLogRules();
+
+      site->next = LOG_SITES;
+      LOG_SITES  = site;
+
+      state = checkLogRules(site);
+
+      site->state.store(state, std::memory_order_release);
+    }
+
+  pthread_mutex_unlock(&LOG_SITES_LOCK);
+
+  return state == LOG_SITE_ON;
+}
+
+void reloadLogSites()
+{
+  pthread_mutex_lock(&LOG_SITES_LOCK);
+
+  loadLogRules();
+
+  for (LogSite *site = LOG_SITES; site; site = site->next)
+    site->state.store(checkLogRules(site), std::memory_order_release);
+
+  pthread_mutex_unlock(&LOG_SITES_LOCK);
+}
+
+static void loadLogRules()
+{
+  const char *environment = getenv(LOG_SITES_ENV);
+
+  size_t environmentSize = environment ? strlen(environment) : 0;
+  size_t fileSize        = getFileSize(LOG_CONTROL_FILE);
+
+  char *rules = (char *) calloc(environmentSize + fileSize + 2, 1);
+
+  if (!rules)
+    return;
+
+  if (environment)
+    memcpy(rules, environment, environmentSize);
+
+  rules[environmentSize] = '\n';
+
+  FILE *control = fileSize ? fopen(LOG_CONTROL_FILE, "r") : nullptr;
+
+  if (control)
+    {
+      // Rules of file are after rules of environment, so they win
+      size_t read = fread(rules + environmentSize + 1, 1, fileSize, control);
+
+      rules[environmentSize + 1 + read] = '\0';
+
+      fclose(control);
+    }
+
+  free(LOG_RULES);
+
+  LOG_RULES        = rules;
+  LOG_RULES_LOADED = 1;
+}
+
+static LOG_SITE_STATE checkLogRules(const LogSite *site)
+{
+  if (site->level == FATAL || !LOG_RULES)
+    return LOG_SITE_ON;
+
+  LOG_SITE_STATE state = LOG_SITE_ON;
+
+  const char *separators = ", \t\r\n";
+
+  for (const char *rule = LOG_RULES + strspn(LOG_RULES, separators); *rule; )
+    {
+      size_t length = strcspn(rule, separators);
+
+      if (length > 1 && (*rule == '+' || *rule == '-') && isRuleMatch(rule + 1, length - 1, site))
+        state = *rule == '+' ? LOG_SITE_ON : LOG_SITE_OFF;
+
+      rule += length;
+      rule += strspn(rule, separators);
+    }
+
+  return state;
+}
+
+static int isRuleMatch(const char *pattern, size_t length, const LogSite *site)
+{
+  if (length == 1 && *pattern == '*')
+    return 1;
+
+  const char *baseName = strrchr(site->fileName, '/');
+
+  baseName = baseName ? baseName + 1 : site->fileName;
+
+  const char *colon = (const char *) memchr(pattern, ':', length);
+
+  if (colon)
+    {
+      size_t nameLength = (size_t) (colon - pattern);
+
+      return strlen(baseName) == nameLength && !strncmp(baseName, pattern, nameLength) &&
+             atoi(colon + 1) == site->line;
+    }
+
+  if (strlen(baseName) == length && !strncmp(baseName, pattern, length))
+    return 1;
+
+  return strlen(site->functionName) == length && !strncmp(site->functionName, pattern, length);
+}
+
+static int isControlFileChanged(timespec *lastChange)
+{
+  struct stat status = {};
+
+  if (stat(LOG_CONTROL_FILE, &status))
+    status.st_mtim = {};
+
+  int isChanged = status.st_mtim.tv_sec  != lastChange->tv_sec ||
+                  status.st_mtim.tv_nsec != lastChange->tv_nsec;
+
+  *lastChange = status.st_mtim;
+
+  return isChanged;
+}
+
+void setLogRotation(const LogRotation *policy, unsigned *error)
+{
+  if (!isPointerCorrect(policy) ||
+      (policy->rotation != LOG_ROTATION_SIZE && policy->rotation != LOG_ROTATION_TIME))
+    {
+      if (isPointerCorrect(error))
+        *error = 1;
+
+      return;
+    }
+
+  LogMaxFileSize.store (policy->maxFileSize ? policy->maxFileSize : DEFAULT_MAX_LOG_FILE_SIZE);
+  LogFileSeconds.store (policy->fileSeconds ? policy->fileSeconds : DEFAULT_LOG_FILE_SECONDS);
+  LogKeepFiles.store   (policy->keepFiles);
+  LogCompress.store    (policy->compress);
+  LogRotationMode.store(policy->rotation);
+}
+
+void setLogOverflow(LOG_OVERFLOW policy)
+{
+  LogOverflow.store(policy);
+}
+
+void setLogPrecision(TIMESTAMP_PRECISION precision)
+{
+  LogPrecision.store(precision);
+}
+
+void flushLog()
+{
+  if (!LOG_FILE)
+    return;
+
+  fflush(LOG_FILE);
+
+  size_t head = LogHead.load(std::memory_order_acquire);
+
+  while (LogWriterRunning.load() && LogTail.load(std::memory_order_acquire) < head)
+    logSleep(LOG_WAIT_SLEEP_NS);
+}
+
+void getLogStats(LogStats *stats)
+{
+  if (!isPointerCorrect(stats))
+    return;
+
+  stats->bytes        = LogBytes.load();
+  stats->writes       = LogWrites.load();
+  stats->droppedBytes = LogDroppedBytes.load();
+  stats->blocks       = LogBlocks.load();
+  stats->rotations    = LogRotations.load();
+}
+
+static const char *getDataString()
+{
+  static thread_local char dataString[TIMESTAMP_SIZE] = "";
+
+  TIMESTAMP_PRECISION precision = (TIMESTAMP_PRECISION) LogPrecision.load(std::memory_order_relaxed);
 
-  char *newLine = strchr(dataString, '\n');
-  if (isPointerCorrect(newLine))
-    *newLine = '\0';
+  formatTimestamp(getTimestamp(precision), dataString, precision);
 
   return dataString;
 }
@@ -0,0 +1,379 @@
+#include <pthread.h>
+#include <time.h>
+#include <atomic>
+#include "scrubber.h"
+#include "validation.h"
+#include "typedstack.h"
+#include "hash.h"
+#include "logging.h"
+#include "systemlike.h"
+
+const size_t   DEFAULT_SCRUB_CHUNK    = 4096;
+const unsigned DEFAULT_SCRUB_INTERVAL = 1000;
+const size_t   DEFAULT_SCRUB_RATE     = 64 * 1024 * 1024;
+const unsigned DEFAULT_SCRUB_CPU      = 10;
+
+const uint64_t MAX_SCRUBBER_SLEEP_NS = 10 * 1000 * 1000;
+
+/// Results of scrubStack()
+enum SCRUB_RESULT {
+  SCRUB_OK,
+  SCRUB_ERROR,
+  SCRUB_GONE,
+  SCRUB_SKIPPED,
+  SCRUB_STOPPED,
+};
+
+static pthread_mutex_t SCRUBBER_LOCK = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_t        Scrubber = {};
+static std::atomic<int> ScrubberRunning {0};
+
+static ScrubberPolicy POLICY = {};
+
+static unsigned DUMPED_VERSION[VALIDATION_REGISTRY_SIZE] = {};
+static int      WAS_DUMPED    [VALIDATION_REGISTRY_SIZE] = {};
+
+static std::atomic<uint64_t> Passes         {0};
+static std::atomic<uint64_t> Stacks         {0};
+static std::atomic<uint64_t> Chunks         {0};
+static std::atomic<uint64_t> Bytes          {0};
+static std::atomic<uint64_t> Mismatches     {0};
+static std::atomic<uint64_t> Restarts       {0};
+static std::atomic<uint64_t> Skipped        {0};
+static std::atomic<uint64_t> CpuNanoseconds {0};
+
+/// Body of scrubber thread
+/// @param [in] arg Unused
+/// @return nullptr
+static void *scrubberLoop(void *arg);
+
+/// Check one registered stack by chunks
+/// @param [in] slot Slot of stack in validation list
+/// @return Result from SCRUB_RESULT
+/// @note If stack is changed between chunks, check starts again with twice bigger chunks,
+/// but only MAX_SCRUB_RESTARTS times
+static SCRUB_RESULT scrubStack(int slot);
+
+/// Check canaries of stack and its array or chunks
+/// @param [in] stk Pointer to stack
+/// @param [in] hasStorage Is pointer to array or to chunks correct
+/// @return Code of error from ERROR
+static unsigned checkCanaries(const Stack *stk, int hasStorage);
+
+/// Sleep after chunk so that rate and CPU budget are kept
+/// @param [in] bytes Count of hashed bytes
+/// @param [in] cpuNs CPU time of chunk
+/// @param [in] wallNs Real time of chunk
+static void throttle(size_t bytes, uint64_t cpuNs, uint64_t wallNs);
+
+/// Sleep, but wake up if scrubber is stopped
+/// @param [in] nanoseconds Time of sleep
+static void scrubberSleep(uint64_t nanoseconds);
+
+/// Get time of clock
+/// @param [in] clock Id of clock
+/// @return Time in nanoseconds
+static uint64_t getNanoseconds(clockid_t clock);
+
+void scrubber_start(const ScrubberPolicy *policy, unsigned *error)
+{
+  ScrubberPolicy settings = {};
+
+  if (policy)
+    {
+      if (!isPointerCorrect(policy) || policy->cpuPercent > 100)
+        {
+          if (isPointerCorrect(error))
+            *error = 1;
+
+          return;
+        }
+
+      settings = *policy;
+    }
+
+  if (!settings.chunkElements)
+    settings.chunkElements  = DEFAULT_SCRUB_CHUNK;
+
+  if (!settings.intervalMs)
+    settings.intervalMs     = DEFAULT_SCRUB_INTERVAL;
+
+  if (!settings.bytesPerSecond)
+    settings.bytesPerSecond = DEFAULT_SCRUB_RATE;
+
+  if (!settings.cpuPercent)
+    settings.cpuPercent     = DEFAULT_SCRUB_CPU;
+
+  pthread_mutex_lock(&SCRUBBER_LOCK);
+
+  if (ScrubberRunning.load())
+    {
+      pthread_mutex_unlock(&SCRUBBER_LOCK);
+
+      if (isPointerCorrect(error))
+        *error = 1;
+
+      return;
+    }
+
+  POLICY = settings;
+
+  validation_retainRegistry();
+
+  ScrubberRunning.store(1);
+
+  if (pthread_create(&Scrubber, nullptr, scrubberLoop, nullptr))
+    {
+      ScrubberRunning.store(0);
+
+      validation_releaseRegistry();
+
+      if (isPointerCorrect(error))
+        *error = 1;
+    }
+
+  pthread_mutex_unlock(&SCRUBBER_LOCK);
+}
+
+void scrubber_stop()
+{
+  pthread_mutex_lock(&SCRUBBER_LOCK);
+
+  if (ScrubberRunning.load())
+    {
+      ScrubberRunning.store(0);
+
+      pthread_join(Scrubber, nullptr);
+
+      validation_releaseRegistry();
+    }
+
+  pthread_mutex_unlock(&SCRUBBER_LOCK);
+}
+
+void scrubber_stats(ScrubberStats *stats)
+{
+  if (!isPointerCorrect(stats))
+    return;
+
+  stats->passes         = Passes.load();
+  stats->stacks         = Stacks.load();
+  stats->chunks         = Chunks.load();
+  stats->bytes          = Bytes.load();
+  stats->mismatches     = Mismatches.load();
+  stats->restarts       = Restarts.load();
+  stats->skipped        = Skipped.load();
+  stats->cpuNanoseconds = CpuNanoseconds.load();
+}
+
+static void *scrubberLoop(void *)
+{
+  while (ScrubberRunning.load())
+    {
+      for (int slot = 0; slot < VALIDATION_REGISTRY_SIZE && ScrubberRunning.load(); ++slot)
+        {
+          SCRUB_RESULT result = scrubStack(slot);
+
+          if (result == SCRUB_OK || result == SCRUB_ERROR)
+            Stacks.fetch_add(1, std::memory_order_relaxed);
+
+          if (result == SCRUB_SKIPPED)
+            Skipped.fetch_add(1, std::memory_order_relaxed);
+        }
+
+      Passes.fetch_add(1, std::memory_order_relaxed);
+
+      scrubberSleep((uint64_t)POLICY.intervalMs * 1000000);
+    }
+
+  return nullptr;
+}
+
+static SCRUB_RESULT scrubStack(int slot)
+{
+  unsigned startVersion = 0;
+  size_t   from         = 0;
+  size_t   chunk        = POLICY.chunkElements;
+  unsigned restarts     = 0;
+
+#ifndef RELEASE_BUILD_
+
+  unsigned hash         = 0;
+
+#endif
+
+  while (ScrubberRunning.load())
+    {
+      uint64_t startCpu  = getNanoseconds(CLOCK_THREAD_CPUTIME_ID);
+      uint64_t startWall = getNanoseconds(CLOCK_MONOTONIC);
+
+      unsigned version = 0;
+
+      const Stack *stk = validation_lockStack(slot, &version);
+
+      if (!stk)
+        {
+          validation_unlockStack(slot);
+
+          return SCRUB_GONE;
+        }
+
+      if (!from)
+        startVersion = version;
+
+      int hasStorage = stk->capacity &&
+                       isPointerCorrect(stk->chunkElements ? (const void *)stk->chunks : stk->array);
+
+      unsigned errorCode = checkCanaries(stk, hasStorage);
+
+      size_t count = 0;
+
+#ifndef RELEASE_BUILD_
+
+      if (!errorCode && hasStorage && ElementStack::HAS_HASH)
+        {
+#ifdef INCREMENTAL_HASH_
+
+          size_t end = stk->capacity - from > chunk ? from + chunk : stk->capacity;
+
+          // Run of slots doesn`t cross border of chunk of segmented stack
+          for (size_t run = 0; from + count < end; count += run)
+            {
+              run = stack_slotsRun(stk, from + count);
+
+              if (run > end - from - count)
+                run = end - from - count;
+
+              hash += getArrayHash(stack_slot(stk, from + count), run, sizeof(Element),
+                                   stk->hashFamily, from + count);
+            }
+
+#else
+
+          count = stk->capacity;
+
+          hash  = stack_arrayHash(stk);
+
+#endif
+
+          from += count;
+
+          if (from >= stk->capacity && hash != stk->arrayHash)
+            errorCode |= DIFFERENT_ARRAY_HASH;
+        }
+
+#endif
+
+      int isLast      = errorCode || !hasStorage || from >= stk->capacity || !ElementStack::HAS_HASH;
+      int isUnchanged = validation_isUnchanged(slot, startVersion);
+
+      if (isUnchanged && errorCode)
+        {
+          Mismatches.fetch_add(1, std::memory_order_relaxed);
+
+          if (!WAS_DUMPED[slot] || DUMPED_VERSION[slot] != startVersion)
+            {
+              stack_dump(stk, errorCode, getLogFile());
+            }
+
+          WAS_DUMPED    [slot] = 1;
+          DUMPED_VERSION[slot] = startVersion;
+        }
+
+      validation_unlockStack(slot);
+
+      Chunks.fetch_add(1, std::memory_order_relaxed);
+      Bytes.fetch_add(count * sizeof(Element), std::memory_order_relaxed);
+
+      uint64_t cpuNs = getNanoseconds(CLOCK_THREAD_CPUTIME_ID) - startCpu;
+
+      CpuNanoseconds.fetch_add(cpuNs, std::memory_order_relaxed);
+
+      throttle(count * sizeof(Element), cpuNs, getNanoseconds(CLOCK_MONOTONIC) - startWall);
+
+      // Array hash is sum of all slots, so chunks are checked by it only if stack wasn`t changed between them.
+      // Pass is started again with twice bigger chunks, but chunk isn`t doubled forever,
+      // because resize of stack waits for whole chunk
+      if (!isUnchanged)
+        {
+          if (restarts++ == MAX_SCRUB_RESTARTS)
+            return SCRUB_SKIPPED;
+
+          Restarts.fetch_add(1, std::memory_order_relaxed);
+
+          from  = 0;
+          chunk = chunk < SIZE_MAX / 2 ? chunk * 2 : SIZE_MAX;
+
+#ifndef RELEASE_BUILD_
+
+          hash  = 0;
+
+#endif
+
+          continue;
+        }
+
+      if (isLast)
+        return errorCode ? SCRUB_ERROR : SCRUB_OK;
+    }
+
+  return SCRUB_STOPPED;
+}
+
+static unsigned checkCanaries(const Stack *stk, int hasStorage)
+{
+  unsigned errorCode = 0;
+
+#ifndef RELEASE_BUILD_
+
+  if constexpr (ElementStack::HAS_CANARIES)
+    {
+      if (stk->leftCanary != LEFT_CANARY)
+        errorCode |= LEFT_CANARY_DIED;
+
+      if (stk->rightCanary != RIGHT_CANARY)
+        errorCode |= RIGHT_CANARY_DIED;
+    }
+
+#endif
+
+  if (!errorCode && hasStorage)
+    errorCode |= stack_arrayCanaries(stk);
+
+  return errorCode;
+}
+
+static void throttle(size_t bytes, uint64_t cpuNs, uint64_t wallNs)
+{
+  uint64_t budgetSleep = cpuNs * (100 - POLICY.cpuPercent) / POLICY.cpuPercent;
+
+  // Product of bytes and nanoseconds in second can overflow 64 bits
+  uint64_t rateTime  = (uint64_t)((double)bytes * 1e9 / (double)POLICY.bytesPerSecond);
+  uint64_t rateSleep = rateTime > wallNs ? rateTime - wallNs : 0;
+
+  scrubberSleep(budgetSleep > rateSleep ? budgetSleep : rateSleep);
+}
+
+static void scrubberSleep(uint64_t nanoseconds)
+{
+  while (nanoseconds && ScrubberRunning.load())
+    {
+      uint64_t step = nanoseconds < MAX_SCRUBBER_SLEEP_NS ? nanoseconds : MAX_SCRUBBER_SLEEP_NS;
+
+      timespec time = {0, (long)step};
+
+      nanosleep(&time, nullptr);
+
+      nanoseconds -= step;
+    }
+}
+
+static uint64_t getNanoseconds(clockid_t clock)
+{
+  timespec now = {};
+
+  clock_gettime(clock, &now);
+
+  return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
@@ -1,23 +1,35 @@
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 #include "stack.h"
 #include "hash.h"
 #include "elementfunctions.h"
 #include "systemlike.h"
 #include "logging.h"
+#include "addressmap.h"
+#include "validation.h"
+#include "guardpages.h"
+#include "typedstack.h"
 
 #pragma GCC diagnostic ignored "-Wcast-qual"
 #pragma GCC diagnostic ignored "-Wconditionally-supported"
 
 #ifndef RELEASE_BUILD_
 
-#define CHECK_VALID(STACK_POINTER, ERROR, ...)                          \
+#define CHECK_VALID_AT(POINT, STACK_POINTER, ERROR, ...)                \
   do                                                                    \
     {                                                                   \
-      unsigned ERROR_CODE_TEMP = stack_valid(STACK_POINTER);            \
+      unsigned ERROR_CODE_TEMP = 0;                                     \
+                                                                        \
+      if (validation_shouldCheck(POINT, STACK_POINTER))                 \
+        ERROR_CODE_TEMP = validation_check(STACK_POINTER);              \
+      else if (!STACK_POINTER)                                          \
+        ERROR_CODE_TEMP = NULL_STACK_POINTER;                           \
                                                                         \
       if (ERROR_CODE_TEMP)                                              \
         {                                                               \
-          stack_dump(STACK_POINTER, ERROR_CODE_TEMP, getLogFile());     \
+          if (ElementStack::HAS_DUMP)                                   \
+            stack_dump(STACK_POINTER, ERROR_CODE_TEMP, getLogFile());   \
                                                                         \
           if (ERROR)                                                    \
             *ERROR = ERROR_CODE_TEMP;                                   \
@@ -26,32 +38,176 @@
         }                                                               \
     } while (0)
 
-#define UPDATE_HASH(STACK_POINTER)                                      \
+#define CHECK_VALID(STACK_POINTER, ERROR, ...)                          \
+  CHECK_VALID_AT(VALIDATION_OPERATION, STACK_POINTER, ERROR, __VA_ARGS__)
+
+#define WRITE_GUARD(STACK_POINTER)                                      \
+  StackWriteGuard WRITE_GUARD_TEMP(STACK_POINTER, 0)
+
+#define RESIZE_GUARD(STACK_POINTER)                                     \
+  StackWriteGuard WRITE_GUARD_TEMP(STACK_POINTER, 1)
+
+#define UPDATE_STRUCT_HASH(STACK_POINTER)                               \
   do                                                                    \
     {                                                                   \
-      STACK_POINTER->arrayHash = getHash(STACK_POINTER->array,          \
-                                         STACK_POINTER->capacity * sizeof(Element)); \
+      if (!ElementStack::HAS_HASH)                                      \
+        break;                                                          \
                                                                         \
       STACK_POINTER->hash = 0;                                          \
-      STACK_POINTER->hash = getHash(STACK_POINTER, sizeof(Stack));      \
+      STACK_POINTER->hash =                                             \
+        getFamilyHash(STACK_POINTER, sizeof(Stack), STACK_POINTER->hashFamily); \
+    } while(0)
+
+#define UPDATE_HASH(STACK_POINTER)                                      \
+  do                                                                    \
+    {                                                                   \
+      if (!ElementStack::HAS_HASH)                                      \
+        break;                                                          \
+                                                                        \
+      STACK_POINTER->arrayHash = stack_arrayHash(STACK_POINTER);        \
+                                                                        \
+      UPDATE_STRUCT_HASH(STACK_POINTER);                                \
+    } while(0)
+
+#ifdef INCREMENTAL_HASH_
+
+#define BEGIN_SLOT_UPDATE(STACK_POINTER, INDEX)                         \
+  do                                                                    \
+    {                                                                   \
+      if (!ElementStack::HAS_HASH)                                      \
+        break;                                                          \
+                                                                        \
+      STACK_POINTER->arrayHash -=                                       \
+        getSlotHash(slotAt(STACK_POINTER, INDEX), sizeof(Element), INDEX, STACK_POINTER->hashFamily); \
+    } while(0)
+
+#define END_SLOT_UPDATE(STACK_POINTER, INDEX)                           \
+  do                                                                    \
+    {                                                                   \
+      if (!ElementStack::HAS_HASH)                                      \
+        break;                                                          \
+                                                                        \
+      STACK_POINTER->arrayHash +=                                       \
+        getSlotHash(slotAt(STACK_POINTER, INDEX), sizeof(Element), INDEX, STACK_POINTER->hashFamily); \
+                                                                        \
+      UPDATE_STRUCT_HASH(STACK_POINTER);                                \
+    } while(0)
+
+#define BEGIN_SLOTS_UPDATE(STACK_POINTER, FROM, COUNT)                  \
+  do                                                                    \
+    {                                                                   \
+      if (!ElementStack::HAS_HASH)                                      \
+        break;                                                          \
+                                                                        \
+      STACK_POINTER->arrayHash -= slotsHash(STACK_POINTER, FROM, COUNT); \
+    } while(0)
+
+#define END_SLOTS_UPDATE(STACK_POINTER, FROM, COUNT)                    \
+  do                                                                    \
+    {                                                                   \
+      if (!ElementStack::HAS_HASH)                                      \
+        break;                                                          \
+                                                                        \
+      STACK_POINTER->arrayHash += slotsHash(STACK_POINTER, FROM, COUNT); \
+                                                                        \
+      UPDATE_STRUCT_HASH(STACK_POINTER);                                \
     } while(0)
 
 #else
 
+#define BEGIN_SLOT_UPDATE(STACK_POINTER, INDEX) ;
+
+#define END_SLOT_UPDATE(STACK_POINTER, INDEX) UPDATE_HASH(STACK_POINTER)
+
+#define BEGIN_SLOTS_UPDATE(STACK_POINTER, FROM, COUNT) ;
+
+#define END_SLOTS_UPDATE(STACK_POINTER, FROM, COUNT) UPDATE_HASH(STACK_POINTER)
+
+#endif
+
+#else
+
+#define CHECK_VALID_AT(POINT, STACK_POINTER, ERROR, ...) ;
+
 #define CHECK_VALID(STACK_POINTER, ERROR, ...) ;
 
+#define WRITE_GUARD(STACK_POINTER) ;
+
+#define RESIZE_GUARD(STACK_POINTER) ;
+
+#define UPDATE_STRUCT_HASH(STACK_POINTER) ;
+
 #define UPDATE_HASH(STACK_POINTER) ;
 
+#define BEGIN_SLOT_UPDATE(STACK_POINTER, INDEX) ;
+
+#define END_SLOT_UPDATE(STACK_POINTER, INDEX) ;
+
+#define BEGIN_SLOTS_UPDATE(STACK_POINTER, FROM, COUNT) ;
+
+#define END_SLOTS_UPDATE(STACK_POINTER, FROM, COUNT) ;
+
+#endif
+
+#ifndef RELEASE_BUILD_
+
+/// Mark stack as changing while guard lives, so background validation skips it
+class StackWriteGuard {
+  public:
+    StackWriteGuard(const Stack *stk, int lock) :
+      slot_(stk->validationSlot),
+      lock_(lock)
+      {
+        if (!validation_beginWrite(slot_, stk, lock_))
+          slot_ = -1;
+      }
+
+    ~StackWriteGuard()
+      {
+        validation_endWrite(slot_, lock_);
+      }
+
+    StackWriteGuard(const StackWriteGuard &) = delete;
+    StackWriteGuard &operator=(const StackWriteGuard &) = delete;
+
+  private:
+    int slot_;
+    int lock_;
+};
+
+#endif
+
+#ifdef ARRAY_CANARIES_
+
+/// Place before array, left canary is in its end, so array starts at ARRAY_ALIGNMENT
+const size_t ARRAY_HEADER_SIZE = ARRAY_ALIGNMENT;
+
 #endif
 
-#define LEFT_CANARY        0xDEADBEAF
-#define RIGHT_CANARY       0xBADC0FEE
-#define LEFT_ARRAY_CANARY  0xBEADFACE
-#define RIGHT_ARRAY_CANARY 0xABADBABE
+const size_t DEFAULT_CHUNK_ELEMENTS = 1024;
+
+/// Get slot of stack
+/// @param [in] stk Pointer to stack
+/// @param [in] index Index of slot
+/// @return Pointer to slot in array or in chunk
+static inline Element *slotAt(const Stack *stk, size_t index)
+{
+  if (!stk->chunkElements)
+    return &stk->array[index];
+
+  return &stk->chunks[index >> stk->chunkShift][index & (stk->chunkElements - 1)];
+}
+
+#if !defined(RELEASE_BUILD_) && defined(INCREMENTAL_HASH_)
+
+/// Calc position-weighted hash of count slots
+/// @param [in] stk Pointer to stack
+/// @param [in] from First slot
+/// @param [in] count Count of slots
+/// @return Hash of slots as part of arrayHash
+static unsigned slotsHash(const Stack *stk, size_t from, size_t count);
 
-const size_t DEFAULT_STACK_GROWTH   =  2;
-const size_t DEFAULT_STACK_OFFSET   =  5;
-const size_t DEFAULT_STACK_CAPACITY = 10;
+#endif
 
 /// Create array for stack if previously stack capacity was 0
 /// @param [in] stk Pointer to stack
@@ -60,11 +216,129 @@ const size_t DEFAULT_STACK_CAPACITY = 10;
 /// @note If size equals zero, that set stack`s array to nullptr
 static void createArray(Stack *stk, size_t size, unsigned *error);
 
+/// Allocate block of elements with stack`s allocator
+/// @param [in] stk Pointer to stack which will own block
+/// @param [in] count Count of elements
+/// @return Pointer to first element or nullptr if was error
+/// @note Block is put between canaries (ARRAY_CANARIES_) or guard pages (GUARD_PAGES_).\n
+/// Memory isn`t zeroed, caller fills it with poison
+static Element *allocBlock(const Stack *stk, size_t count);
+
+/// Free block from allocBlock()
+/// @param [in] stk Pointer to stack which owns block
+/// @param [in] block Pointer to first element
+/// @param [in] count Count of elements
+static void freeBlock(const Stack *stk, Element *block, size_t count);
+
+#ifndef GUARD_PAGES_
+
+/// Get size of memory of block
+/// @param [in] count Count of elements
+/// @return Size of block with canaries in bytes
+static size_t blockSize(size_t count);
+
+/// Get start of memory of block
+/// @param [in] block Pointer to first element
+/// @return Pointer which was given by allocator
+static void *blockBegin(Element *block);
+
+#endif
+
+/// Allocate array and add it to known ranges
+/// @param [in] stk Pointer to stack which will own array
+/// @param [in] capacity Count of elements
+/// @return Pointer to first element or nullptr if was error
+static Element *allocArray(const Stack *stk, size_t capacity);
+
+/// Change capacity of stack`s array
+/// @param [in] stk Pointer to stack
+/// @param [in] newCapacity New count of elements
+/// @return Pointer to first element or nullptr if was error, then old array is kept
+/// @note Elements are kept, new slots aren`t initialized
+static Element *reallocArray(const Stack *stk, size_t newCapacity);
+
+/// Free stack`s array or all chunks and directory of segmented stack
+/// @param [in] stk Pointer to stack
+static void freeArray(const Stack *stk);
+
+/// Change count of chunks of segmented stack
+/// @param [in/out] stk Pointer to stack
+/// @param [in] newCapacity New capacity, multiple of chunkElements
+/// @return 1 if chunks were changed or 0 if was error, then stack isn`t changed
+/// @note New slots aren`t initialized
+static int resizeChunks(Stack *stk, size_t newCapacity);
+
+/// Give free chunk back
+/// @param [in/out] stk Pointer to stack
+/// @param [in] chunk Pointer to chunk
+/// @note Chunk becomes spareChunk if there is no spare chunk, else it is freed
+static void releaseChunk(Stack *stk, Element *chunk);
+
+/// Get count of slots from index till end of chunk
+/// @param [in] stk Pointer to stack
+/// @param [in] index Index of slot
+/// @return Count of slots in same block of memory
+/// @note Array isn`t limited, because resize fills slots after old capacity
+static size_t runLength(const Stack *stk, size_t index);
+
+/// Get capacity for size elements using growth policy
+/// @param [in] stk Pointer to stack
+/// @param [in] size Count of elements which must be in array
+/// @return New capacity or current capacity if it is enough
+static size_t growCapacity(const Stack *stk, size_t size);
+
+/// Get capacity after auto-shrink using growth policy
+/// @param [in] stk Pointer to stack
+/// @param [in] capacity Capacity before shrink
+/// @return New capacity or capacity if array shouldn`t shrink
+/// @note Shrink only when size * shrinkDivider <= capacity, so there is gap
+/// between points of grow and shrink and array doesn`t resize on each push/pop
+static size_t shrinkCapacity(const Stack *stk, size_t capacity);
+
+/// Fill slots with poison
+/// @param [in/out] stk Pointer to stack
+/// @param [in] from First slot
+/// @param [in] to Slot after last
+/// @note Trivially copyable poison is written once and then copied by doubling memcpy
+static void fillPoison(Stack *stk, size_t from, size_t to);
+
+/// Make slots after pop free
+/// @param [in/out] stk Pointer to stack
+/// @param [in] from First free slot
+/// @param [in] to Slot after last free slot
+/// @note With LAZY_POISON_ only moves poisonedFrom if it is possible
+static void freeSlots(Stack *stk, size_t from, size_t to);
+
+/// Copy count elements
+/// @param [out] target Pointer to first target element
+/// @param [in] source Pointer to first source element
+/// @param [in] count Count of elements
+/// @param [in] copyFunction Function for copy Elements
+/// @note Trivially copyable Elements are copied with one memcpy
+static void copyElements(Element *target, const Element *source, size_t count,
+                         void (*copyFunction)(Element *, const Element *));
+
+/// Copy count elements into slots
+/// @param [in/out] stk Pointer to stack
+/// @param [in] from First slot
+/// @param [in] elements Pointer to first element
+/// @param [in] count Count of elements
+static void copyToSlots(Stack *stk, size_t from, const Element *elements, size_t count);
+
+/// Copy count elements from slots
+/// @param [in] stk Pointer to stack
+/// @param [in] from First slot
+/// @param [out] elements Pointer to first element
+/// @param [in] count Count of elements
+static void copyFromSlots(const Stack *stk, size_t from, Element *elements, size_t count);
+
 
 unsigned stack_valid(const Stack *stk)
 {
 #ifdef RELEASE_BUILD_
 
+  (void)stk;
+
   return 0;
 
 #else
@@ -80,41 +354,53 @@ unsigned stack_valid(const Stack *stk)
   if ((stk->status & EMPTY) && !(stk->lastElementIndex + 1))
     error |= INCORRECT_STATUS;
 
-  if (!isPointerCorrect(stk->array) && stk->capacity)
+  int hasStorage = stk->chunkElements ? isPointerCorrect(stk->chunks) : isPointerCorrect(stk->array);
+
+  for (size_t i = 0; hasStorage && stk->chunkElements && i < (stk->capacity >> stk->chunkShift); ++i)
+    hasStorage = isPointerCorrect(stk->chunks[i]);
+
+  if (!hasStorage && stk->capacity)
     error |= NULL_ARRAY_POINTER;
 
   if (stk->capacity < stk->lastElementIndex)
     error |= CAPACITY_LESS_THAN_SIZE;
 
-  if (!isPointerCorrect((void *)stk->copyFunction))
-    error |= NOT_COPYFUNCTION;
+#ifdef LAZY_POISON_
+
+  if (stk->poisonedFrom < stk->lastElementIndex || stk->poisonedFrom > stk->capacity)
+    error |= INCORRECT_POISON_BORDER;
 
-  if (stk->leftCanary != LEFT_CANARY)
-    error |= LEFT_CANARY_DIED;
+#endif
 
-  if (stk->rightCanary != RIGHT_CANARY)
-    error |= RIGHT_CANARY_DIED;
+  if (!isPointerCorrect((void *)stk->copyFunction))
+    error |= NOT_COPYFUNCTION;
 
-  if (isPointerCorrect(stk->array))
+  if constexpr (ElementStack::HAS_CANARIES)
     {
-      if (*(CANARY *)((char *)stk->array - sizeof(CANARY)) != LEFT_ARRAY_CANARY)
-        error |= LEFT_ARRAY_CANARY_DIED;
+      if (stk->leftCanary != LEFT_CANARY)
+        error |= LEFT_CANARY_DIED;
 
-      if (*(CANARY *)(stk->array + stk->capacity)  != RIGHT_ARRAY_CANARY)
-        error |= RIGHT_ARRAY_CANARY_DIED;
+      if (stk->rightCanary != RIGHT_CANARY)
+        error |= RIGHT_CANARY_DIED;
 
-      if (getHash(stk->array, stk->capacity * sizeof(Element)) != stk->arrayHash)
-        error |= DIFFERENT_ARRAY_HASH;
+      if (hasStorage)
+        error |= stack_arrayCanaries(stk);
     }
 
-  unsigned hash = stk->hash;
+  if constexpr (ElementStack::HAS_HASH)
+    {
+      if (hasStorage && stack_arrayHash(stk) != stk->arrayHash)
+        error |= DIFFERENT_ARRAY_HASH;
 
-  stk->hash = 0;
+      Stack copy = {};
 
-  if (getHash(stk, sizeof(Stack)) != hash)
-    error |= DIFFERENT_HASH;
+      memcpy(&copy, stk, sizeof(Stack));
 
-  stk->hash = hash;
+      copy.hash = 0;
+
+      if (getFamilyHash(&copy, sizeof(Stack), stk->hashFamily) != stk->hash)
+        error |= DIFFERENT_HASH;
+    }
 
   if (!isPointerCorrect(stk->info.name))
     error |= NOT_NAME;
@@ -133,11 +419,78 @@ unsigned stack_valid(const Stack *stk)
 #endif
 }
 
+unsigned stack_arrayCanaries(const Stack *stk)
+{
+  unsigned error = 0;
+
+#ifdef ARRAY_CANARIES_
+
+  size_t blocks   = stk->chunkElements ? stk->capacity >> stk->chunkShift : (stk->array ? 1 : 0);
+  size_t elements = stk->chunkElements ? stk->chunkElements : stk->capacity;
+
+  for (size_t i = 0; i < blocks; ++i)
+    {
+      Element *block = stk->chunkElements ? stk->chunks[i] : stk->array;
+
+      if (*(CANARY *)((char *)block - sizeof(CANARY)) != LEFT_ARRAY_CANARY)
+        error |= LEFT_ARRAY_CANARY_DIED;
+
+      if (*(CANARY *)(block + elements) != RIGHT_ARRAY_CANARY)
+        error |= RIGHT_ARRAY_CANARY_DIED;
+    }
+
+#else
+
+  (void)stk;
+
+#endif
+
+  return error;
+}
+
+unsigned stack_arrayHash(const Stack *stk)
+{
+#if defined(RELEASE_BUILD_)
+
+  (void)stk;
+
+  return 0;
+
+#elif defined(INCREMENTAL_HASH_)
+
+  return slotsHash(stk, 0, stk->capacity);
+
+#else
+
+  if (!stk->chunkElements)
+    return getFamilyHash(stk->array, stk->capacity * sizeof(Element), stk->hashFamily);
+
+  unsigned hash = 0;
+
+  for (size_t i = 0; i < (stk->capacity >> stk->chunkShift); ++i)
+    hash = hash * 33 + getFamilyHash(stk->chunks[i], stk->chunkElements * sizeof(Element), stk->hashFamily);
+
+  return hash;
+
+#endif
+}
+
+const Element *stack_slot(const Stack *stk, size_t index)
+{
+  return slotAt(stk, index);
+}
+
+size_t stack_slotsRun(const Stack *stk, size_t index)
+{
+  return stk->chunkElements ? runLength(stk, index) : stk->capacity - index;
+}
+
 void do_stack_init(Stack *stk, size_t capacity, void (*copyFunction)(Element *, const Element *),
+                  const StackAllocator *allocator,
                   const char *name, const char *fileName, const char *functionName, int line,
                   unsigned *error)
 {
-  if (!isPointerCorrect(stk) || !isPointerCorrect((void *)copyFunction) || !isPointerCorrect(name) || !isPointerCorrect(fileName) || !isPointerCorrect(functionName) || (line <= 0) || (stk->status & INIT))
+  if (!isPointerCorrect(stk) || !isPointerCorrect((void *)copyFunction) || (allocator && !isPointerCorrect(allocator)) || !isPointerCorrect(name) || !isPointerCorrect(fileName) || !isPointerCorrect(functionName) || (line <= 0) || (stk->status & INIT))
       {
         if (isPointerCorrect(error))
             *error = 1;
@@ -147,15 +500,42 @@ void do_stack_init(Stack *stk, size_t capacity, void (*copyFunction)(Element *,
 
 #ifndef RELEASE_BUILD_
 
+    // Stack at this address could be left without stack_destroy()
+    validation_unregister(stk);
+
     stk->leftCanary  = LEFT_CANARY;
     stk->rightCanary = RIGHT_CANARY;
 
 #endif
 
+    stk->chunks           = nullptr;
+    stk->chunksSize       = 0;
+    stk->spareChunk       = nullptr;
+    stk->chunkElements    = 0;
+    stk->chunkShift       = 0;
+
     stk->capacity         = capacity;
     stk->lastElementIndex = 0;
     stk->status           = INIT | EMPTY;
+
+#ifdef LAZY_POISON_
+
+    stk->poisonedFrom     = 0;
+
+#endif
+
     stk->copyFunction     = copyFunction;
+    stk->allocator        = allocator ? allocator : &MALLOC_ALLOCATOR;
+
+    stk->growth.growthFactor  = DEFAULT_STACK_GROWTH;
+    stk->growth.shrinkDivider = DEFAULT_STACK_SHRINK;
+    stk->growth.minCapacity   = DEFAULT_STACK_CAPACITY;
+    stk->growth.neverShrink   = 0;
+
+    stk->reservedCapacity = 0;
+
+    stk->growCount   = 0;
+    stk->shrinkCount = 0;
 
 #ifndef RELEASE_BUILD_
 
@@ -164,6 +544,9 @@ void do_stack_init(Stack *stk, size_t capacity, void (*copyFunction)(Element *,
     stk->info.functionName     = functionName;
     stk->info.line             = line;
 
+    stk->hashFamily            = HASH_CRC32C;
+    stk->validationSlot        = -1;
+
 #endif
 
     if (capacity == 0)
@@ -176,14 +559,33 @@ void do_stack_init(Stack *stk, size_t capacity, void (*copyFunction)(Element *,
           return;
       }
 
+#ifndef RELEASE_BUILD_
+
+    stk->validationSlot = validation_register(stk);
+
+#endif
+
     UPDATE_HASH(stk);
 
-    CHECK_VALID(stk, error);
+#ifndef RELEASE_BUILD_
+
+    validation_endWrite(stk->validationSlot, 0);
+
+#endif
+
+    CHECK_VALID_AT(VALIDATION_RESIZE, stk, error);
 }
 
 void stack_destroy(Stack *stk, unsigned *error)
 {
-  CHECK_VALID(stk, error);
+#ifndef RELEASE_BUILD_
+
+  // Even broken stack leaves list, so that list doesn`t keep pointer to freed memory
+  validation_unregister(stk);
+
+#endif
+
+  CHECK_VALID_AT(VALIDATION_RESIZE, stk, error);
 
   if (!(stk->status & INIT))
     {
@@ -195,15 +597,16 @@ void stack_destroy(Stack *stk, unsigned *error)
 
 #ifndef RELEASE_BUILD_
 
-  if (isPointerCorrect(stk->array))
-    free((char *)stk->array - sizeof(CANARY));
+  stk->validationSlot = -1;
 
-#else
+#endif
 
-  free(stk->array);
+  freeArray(stk);
 
-#endif
-  stk->array = nullptr;
+  stk->array      = nullptr;
+  stk->chunks     = nullptr;
+  stk->chunksSize = 0;
+  stk->spareChunk = nullptr;
 
   stk->capacity         = 0;
   stk->lastElementIndex = 0;
@@ -219,6 +622,8 @@ void stack_push(Stack *stk, const Element *element, unsigned *error)
 {
   CHECK_VALID(stk, error);
 
+  WRITE_GUARD(stk);
+
   if (!isPointerCorrect(element))
   {
     if (isPointerCorrect(error))
@@ -229,22 +634,37 @@ void stack_push(Stack *stk, const Element *element, unsigned *error)
 
   if (stk->lastElementIndex == stk->capacity)
     {
-      stack_resize(stk, stk->capacity ? stk->capacity * DEFAULT_STACK_GROWTH : DEFAULT_STACK_CAPACITY);
+      unsigned resizeError = 0;
 
-      if (!isPointerCorrect(stk->array))
+      stack_resize(stk, growCapacity(stk, stk->lastElementIndex + 1), &resizeError);
+
+      if (resizeError || stk->lastElementIndex == stk->capacity)
         {
           if (isPointerCorrect(error))
-            *error = 1;
+            *error = resizeError ? resizeError : 1;
 
           return;
         }
     }
 
-  stk->copyFunction(&stk->array[(stk->lastElementIndex)++], element);
+  size_t index = stk->lastElementIndex;
+
+  BEGIN_SLOT_UPDATE(stk, index);
+
+  stk->copyFunction(slotAt(stk, index), element);
+
+  ++stk->lastElementIndex;
+
+#ifdef LAZY_POISON_
+
+  if (stk->poisonedFrom < stk->lastElementIndex)
+    stk->poisonedFrom = stk->lastElementIndex;
+
+#endif
 
   stk->status &= NOT_EMPTY;
 
-  UPDATE_HASH(stk);
+  END_SLOT_UPDATE(stk, index);
 
   CHECK_VALID(stk, error);
 }
@@ -253,6 +673,8 @@ void stack_pop(Stack *stk, Element *element, unsigned *error)
 {
   CHECK_VALID(stk, error);
 
+  WRITE_GUARD(stk);
+
   if (!isPointerCorrect(element) || (stk->status & EMPTY))
   {
     if (isPointerCorrect(error))
@@ -261,133 +683,443 @@ void stack_pop(Stack *stk, Element *element, unsigned *error)
     return;
   }
 
-  stk->copyFunction(element, &stk->array[--(stk->lastElementIndex)]);
+  size_t index = --stk->lastElementIndex;
 
-  Element poison = getPoison(&stk->array[0]);
+  stk->copyFunction(element, slotAt(stk, index));
 
-  stk->copyFunction(&stk->array[stk->lastElementIndex], &poison);
+  BEGIN_SLOT_UPDATE(stk, index);
+
+  freeSlots(stk, index, index + 1);
 
   if (stk->lastElementIndex == 0)
     stk->status |= EMPTY;
 
-  UPDATE_HASH(stk);
+  END_SLOT_UPDATE(stk, index);
 
-  if (stk->lastElementIndex < stk->capacity / DEFAULT_STACK_GROWTH - DEFAULT_STACK_OFFSET)
+  size_t newCapacity = shrinkCapacity(stk, stk->capacity);
+
+  if (newCapacity != stk->capacity)
     {
-      stack_resize(stk, stk->capacity / DEFAULT_STACK_GROWTH);
+      unsigned resizeError = 0;
 
-      if (!isPointerCorrect(stk->array))
+      stack_resize(stk, newCapacity, &resizeError);
+
+      if (resizeError)
         {
           if (isPointerCorrect(error))
-            *error = 1;
+            *error = resizeError;
 
           return;
         }
     }
 
-  UPDATE_HASH(stk);
-
   CHECK_VALID(stk, error);
 }
 
-void stack_resize(Stack *stk, size_t newSize, unsigned *error)
+void stack_push_n(Stack *stk, const Element *elements, size_t count, unsigned *error)
 {
   CHECK_VALID(stk, error);
 
-  if (newSize && !stk->array)
-    {
-      createArray(stk, newSize, error);
-
-      if (!isPointerCorrect(stk->array))
-        return;
+  WRITE_GUARD(stk);
 
-      Element poison = getPoison(&stk->array[0]);
+  if (!count)
+    return;
 
-      for (size_t i = 0; i < newSize; ++i)
-        stk->copyFunction(&stk->array[i], &poison);
-    }
-  if (newSize)
+  if (!isPointerCorrect(elements))
     {
-#ifndef RELEASE_BUILD_
-
-      stk->array = (Element *)((char *)stk->array - sizeof(CANARY));
-
-      Element *temp = (Element *) recalloc(stk->array, 1,  newSize*sizeof(Element) + 2*sizeof(CANARY));
-
-#else
-
-      Element *temp = (Element *) recalloc(stk->array, 1,  newSize*sizeof(Element));
-
-#endif
-
-      if (isPointerCorrect(temp))
-        {
-#ifndef RELEASE_BUILD_
+      if (isPointerCorrect(error))
+        *error = 1;
 
-          stk->array = temp;
+      return;
+    }
 
-          stk->array = (Element *)((char *)stk->array + sizeof(CANARY));
+  size_t newSize = stk->lastElementIndex + count;
 
-          *(CANARY *)(stk->array + newSize) = RIGHT_ARRAY_CANARY;
+  if (newSize > stk->capacity)
+    {
+      unsigned resizeError = 0;
 
-          if (stk->capacity < newSize)
-            {
-              Element poison = getPoison(&stk->array[0]);
+      stack_resize(stk, growCapacity(stk, newSize), &resizeError);
 
-              for (size_t i = 0; i < newSize - stk->capacity; ++ i)
-                stk->copyFunction(&stk->array[stk->capacity + i], &poison);
-            }
-#endif
-        }
-      else
+      if (resizeError || stk->capacity < newSize)
         {
           if (isPointerCorrect(error))
-            *error = 1;
+            *error = resizeError ? resizeError : 1;
 
           return;
         }
     }
-  else
-    {
-#ifndef RELEASE_BUILD_
 
-      stk->array = (Element *)((char *)stk->array - sizeof(CANARY));
+  size_t from = stk->lastElementIndex;
 
-      free(stk->array);
+  BEGIN_SLOTS_UPDATE(stk, from, count);
 
-#else
+  copyToSlots(stk, from, elements, count);
 
-      free(stk->array);
+  stk->lastElementIndex = newSize;
 
-#endif
+#ifdef LAZY_POISON_
 
-      stk->array = nullptr;
-    }
+  if (stk->poisonedFrom < stk->lastElementIndex)
+    stk->poisonedFrom = stk->lastElementIndex;
 
-  stk->capacity = newSize;
+#endif
 
-  UPDATE_HASH(stk);
+  stk->status &= NOT_EMPTY;
+
+  END_SLOTS_UPDATE(stk, from, count);
 
   CHECK_VALID(stk, error);
 }
 
-size_t stack_size(const Stack *stk, unsigned *error)
+void stack_pop_n(Stack *stk, Element *elements, size_t count, unsigned *error)
 {
-  CHECK_VALID(stk, error, -1u);
+  CHECK_VALID(stk, error);
 
-  return stk->lastElementIndex + 1;
-}
+  WRITE_GUARD(stk);
 
-size_t stack_capacity(const Stack *stk, unsigned *error)
-{
-  CHECK_VALID(stk, error, -1u);
+  if (!count)
+    return;
 
-  return stk->capacity;
+  if (!isPointerCorrect(elements) || count > stk->lastElementIndex)
+    {
+      if (isPointerCorrect(error))
+        *error = 1;
+
+      return;
+    }
+
+  size_t from = stk->lastElementIndex - count;
+
+  copyFromSlots(stk, from, elements, count);
+
+  BEGIN_SLOTS_UPDATE(stk, from, count);
+
+  freeSlots(stk, from, stk->lastElementIndex);
+
+  stk->lastElementIndex = from;
+
+  if (stk->lastElementIndex == 0)
+    stk->status |= EMPTY;
+
+  END_SLOTS_UPDATE(stk, from, count);
+
+  size_t newCapacity = stk->capacity;
+
+  for (size_t capacity = shrinkCapacity(stk, newCapacity); capacity != newCapacity;
+       capacity = shrinkCapacity(stk, newCapacity))
+    newCapacity = capacity;
+
+  if (newCapacity != stk->capacity)
+    {
+      unsigned resizeError = 0;
+
+      stack_resize(stk, newCapacity, &resizeError);
+
+      if (resizeError)
+        {
+          if (isPointerCorrect(error))
+            *error = resizeError;
+
+          return;
+        }
+    }
+
+  CHECK_VALID(stk, error);
+}
+
+void stack_resize(Stack *stk, size_t newSize, unsigned *error)
+{
+  CHECK_VALID_AT(VALIDATION_RESIZE, stk, error);
+
+  RESIZE_GUARD(stk);
+
+  if (newSize < stk->lastElementIndex)
+    {
+      if (isPointerCorrect(error))
+        *error = 1;
+
+      return;
+    }
+
+  if (stk->chunkElements)
+    newSize = (newSize + stk->chunkElements - 1) >> stk->chunkShift << stk->chunkShift;
+
+  if (newSize == stk->capacity)
+    return;
+
+  if (stk->chunkElements)
+    {
+      if (!resizeChunks(stk, newSize))
+        {
+          if (isPointerCorrect(error))
+            *error = 1;
+
+          return;
+        }
+
+#ifndef LAZY_POISON_
+
+      if (stk->capacity < newSize)
+        fillPoison(stk, stk->capacity, newSize);
+
+#endif
+    }
+  else if (!newSize)
+    {
+      freeArray(stk);
+
+      stk->array = nullptr;
+    }
+  else if (!stk->array)
+    {
+      createArray(stk, newSize, error);
+
+      if (!isPointerCorrect(stk->array))
+        return;
+    }
+  else
+    {
+      Element *array = reallocArray(stk, newSize);
+
+      if (!array)
+        {
+          if (isPointerCorrect(error))
+            *error = 1;
+
+          return;
+        }
+
+      stk->array = array;
+
+#ifndef LAZY_POISON_
+
+      if (stk->capacity < newSize)
+        fillPoison(stk, stk->capacity, newSize);
+
+#endif
+    }
+
+#ifdef LAZY_POISON_
+
+  if (stk->poisonedFrom > newSize)
+    stk->poisonedFrom = newSize;
+
+#endif
+
+  if (newSize > stk->capacity)
+    ++stk->growCount;
+  else if (newSize < stk->capacity)
+    ++stk->shrinkCount;
+
+  stk->capacity = newSize;
+
+  UPDATE_HASH(stk);
+
+  CHECK_VALID_AT(VALIDATION_RESIZE, stk, error);
+}
+
+void stack_setSegmented(Stack *stk, size_t chunkElements, unsigned *error)
+{
+  CHECK_VALID_AT(VALIDATION_RESIZE, stk, error);
+
+  RESIZE_GUARD(stk);
+
+  if (!chunkElements)
+    chunkElements = DEFAULT_CHUNK_ELEMENTS;
+
+  if (stk->lastElementIndex || stk->chunkElements || (chunkElements & (chunkElements - 1)))
+    {
+      if (isPointerCorrect(error))
+        *error = 1;
+
+      return;
+    }
+
+  freeArray(stk);
+
+  stk->array = nullptr;
+
+  stk->chunkElements = chunkElements;
+  stk->chunkShift    = 0;
+
+  while (((size_t)1 << stk->chunkShift) < chunkElements)
+    ++stk->chunkShift;
+
+  stk->capacity = 0;
+
+#ifdef LAZY_POISON_
+
+  stk->poisonedFrom = 0;
+
+#endif
+
+  UPDATE_HASH(stk);
+
+  CHECK_VALID_AT(VALIDATION_RESIZE, stk, error);
+}
+
+void stack_setGrowthPolicy(Stack *stk, const GrowthPolicy *policy, unsigned *error)
+{
+  CHECK_VALID(stk, error);
+
+  WRITE_GUARD(stk);
+
+  if (!isPointerCorrect(policy))
+    {
+      if (isPointerCorrect(error))
+        *error = 1;
+
+      return;
+    }
+
+  GrowthPolicy growth = *policy;
+
+  if (!growth.growthFactor)
+    growth.growthFactor  = DEFAULT_STACK_GROWTH;
+
+  if (!growth.shrinkDivider)
+    growth.shrinkDivider = DEFAULT_STACK_SHRINK;
+
+  if (!growth.minCapacity)
+    growth.minCapacity   = DEFAULT_STACK_CAPACITY;
+
+  if (growth.growthFactor < 2 || growth.shrinkDivider <= growth.growthFactor)
+    {
+      if (isPointerCorrect(error))
+        *error = 1;
+
+      return;
+    }
+
+  stk->growth = growth;
+
+  UPDATE_STRUCT_HASH(stk);
+
+  CHECK_VALID(stk, error);
+}
+
+void stack_reserve(Stack *stk, size_t n, unsigned *error)
+{
+  CHECK_VALID(stk, error);
+
+  WRITE_GUARD(stk);
+
+  if (n > stk->capacity)
+    {
+      unsigned resizeError = 0;
+
+      stack_resize(stk, n, &resizeError);
+
+      if (resizeError)
+        {
+          if (isPointerCorrect(error))
+            *error = resizeError;
+
+          return;
+        }
+    }
+
+  stk->reservedCapacity = n;
+
+  UPDATE_STRUCT_HASH(stk);
+
+  CHECK_VALID(stk, error);
+}
+
+void stack_pinCapacity(Stack *stk, int pin, unsigned *error)
+{
+  CHECK_VALID(stk, error);
+
+  (void)error;
+
+  WRITE_GUARD(stk);
+
+  stk->growth.neverShrink = pin;
+
+  UPDATE_STRUCT_HASH(stk);
+
+  CHECK_VALID(stk, error);
+}
+
+void stack_shrink_to_fit(Stack *stk, unsigned *error)
+{
+  CHECK_VALID(stk, error);
+
+  WRITE_GUARD(stk);
+
+  stk->reservedCapacity = 0;
+
+  UPDATE_STRUCT_HASH(stk);
+
+  if (stk->capacity != stk->lastElementIndex)
+    stack_resize(stk, stk->lastElementIndex, error);
+
+  CHECK_VALID(stk, error);
+}
+
+void stack_setHashFamily(Stack *stk, HASH_FAMILY family, unsigned *error)
+{
+  CHECK_VALID(stk, error);
+
+  WRITE_GUARD(stk);
+
+  if (family != HASH_DJB && family != HASH_CRC32C && family != HASH_XXH32)
+    {
+      if (isPointerCorrect(error))
+        *error = 1;
+
+      return;
+    }
+
+#ifndef RELEASE_BUILD_
+
+  stk->hashFamily = family;
+
+#else
+
+  (void)stk;
+
+#endif
+
+  UPDATE_HASH(stk);
+
+  CHECK_VALID(stk, error);
+}
+
+void stack_resizeCount(const Stack *stk, size_t *grows, size_t *shrinks, unsigned *error)
+{
+  CHECK_VALID(stk, error);
+
+  (void)error;
+
+  if (isPointerCorrect(grows))
+    *grows   = stk->growCount;
+
+  if (isPointerCorrect(shrinks))
+    *shrinks = stk->shrinkCount;
+}
+
+size_t stack_size(const Stack *stk, unsigned *error)
+{
+  CHECK_VALID(stk, error, -1u);
+  (void)error;
+
+  return stk->lastElementIndex + 1;
+}
+
+size_t stack_capacity(const Stack *stk, unsigned *error)
+{
+  CHECK_VALID(stk, error, -1u);
+  (void)error;
+
+  return stk->capacity;
 }
 
 int stack_isEmpty(const Stack *stk, unsigned *error)
 {
   CHECK_VALID(stk, error, 0);
+  (void)error;
 
   return stk->status & EMPTY;
 }
@@ -401,36 +1133,434 @@ static void createArray(Stack *stk, size_t size, unsigned *error)
       return;
     }
 
-#ifndef RELEASE_BUILD_
+  stk->array = allocArray(stk, size);
+
+  if (!stk->array)
+    {
+      if (isPointerCorrect(error))
+        *error = 1;
 
-  stk->array = (Element *) calloc(1, size*sizeof(Element) + 2*sizeof(CANARY));
+      return;
+    }
+
+#ifdef LAZY_POISON_
+
+  stk->poisonedFrom = 0;
 
 #else
 
-  stk->array = (Element *) calloc(1, size*sizeof(Element));
+  fillPoison(stk, 0, size);
+
+#endif
+}
+
+static Element *allocBlock(const Stack *stk, size_t count)
+{
+#if defined(GUARD_PAGES_)
+
+  return (Element *) guardAlloc(count*sizeof(Element), stk);
+
+#elif defined(ARRAY_CANARIES_)
+
+  char *memory = (char *) stk->allocator->allocate(stk->allocator->context, blockSize(count), ARRAY_ALIGNMENT);
+
+  if (!memory)
+    return nullptr;
+
+  Element *block = (Element *)(memory + ARRAY_HEADER_SIZE);
+
+  *(CANARY *)((char *)block - sizeof(CANARY)) = LEFT_ARRAY_CANARY;
+  *(CANARY *)(block + count)                  = RIGHT_ARRAY_CANARY;
+
+  return block;
+
+#else
+
+  return (Element *) stk->allocator->allocate(stk->allocator->context, blockSize(count), ARRAY_ALIGNMENT);
+
+#endif
+}
+
+static void freeBlock(const Stack *stk, Element *block, size_t count)
+{
+#if defined(GUARD_PAGES_)
+
+  (void)stk;
+
+  guardFree(block, count*sizeof(Element));
+
+#else
+
+  stk->allocator->deallocate(stk->allocator->context, blockBegin(block), blockSize(count));
+
+#endif
+}
+
+#ifndef GUARD_PAGES_
+
+static size_t blockSize(size_t count)
+{
+#ifdef ARRAY_CANARIES_
+
+  return ARRAY_HEADER_SIZE + count*sizeof(Element) + sizeof(CANARY);
+
+#else
+
+  return count*sizeof(Element);
+
+#endif
+}
+
+static void *blockBegin(Element *block)
+{
+#ifdef ARRAY_CANARIES_
+
+  return (char *)block - ARRAY_HEADER_SIZE;
+
+#else
+
+  return block;
+
+#endif
+}
 
 #endif
 
-  if (!isPointerCorrect(stk->array))
+static Element *allocArray(const Stack *stk, size_t capacity)
+{
+  Element *array = allocBlock(stk, capacity);
+
+#ifndef GUARD_PAGES_
+
+  if (array)
+    addKnownRange(blockBegin(array), blockSize(capacity));
+
+#endif
+
+  return array;
+}
+
+static Element *reallocArray(const Stack *stk, size_t newCapacity)
+{
+#if defined(GUARD_PAGES_)
+
+  Element *array = allocArray(stk, newCapacity);
+
+  if (!array)
+    return nullptr;
+
+  memcpy(array, stk->array, (stk->capacity < newCapacity ? stk->capacity : newCapacity) * sizeof(Element));
+
+  freeArray(stk);
+
+  return array;
+
+#else
+
+  void *block = blockBegin(stk->array);
+
+  removeKnownRange(block);
+
+  char *memory = (char *) stk->allocator->reallocate(stk->allocator->context, block, blockSize(stk->capacity),
+                                                     blockSize(newCapacity), ARRAY_ALIGNMENT);
+
+  if (!memory)
     {
-      if (isPointerCorrect(error))
-        *error = 1;
+      addKnownRange(block, blockSize(stk->capacity));
+
+      return nullptr;
+    }
+
+  addKnownRange(memory, blockSize(newCapacity));
+
+#ifdef ARRAY_CANARIES_
+
+  Element *array = (Element *)(memory + ARRAY_HEADER_SIZE);
+
+  *(CANARY *)(array + newCapacity) = RIGHT_ARRAY_CANARY;
+
+  return array;
+
+#else
+
+  return (Element *)memory;
+
+#endif
+
+#endif
+}
+
+static void freeArray(const Stack *stk)
+{
+  if (stk->chunkElements)
+    {
+      for (size_t i = 0; i < (stk->capacity >> stk->chunkShift); ++i)
+        freeBlock(stk, stk->chunks[i], stk->chunkElements);
+
+      if (stk->spareChunk)
+        freeBlock(stk, stk->spareChunk, stk->chunkElements);
+
+      if (stk->chunks)
+        {
+          removeKnownRange(stk->chunks);
+
+          stk->allocator->deallocate(stk->allocator->context, stk->chunks, stk->chunksSize * sizeof(Element *));
+        }
 
       return;
     }
 
-#ifndef RELEASE_BUILD_
+  if (!stk->array)
+    return;
+
+#ifndef GUARD_PAGES_
+
+  removeKnownRange(blockBegin(stk->array));
+
+#endif
+
+  freeBlock(stk, stk->array, stk->capacity);
+}
+
+static int resizeChunks(Stack *stk, size_t newCapacity)
+{
+  size_t oldCount = stk->capacity >> stk->chunkShift;
+  size_t newCount = newCapacity   >> stk->chunkShift;
+
+  if (newCount > stk->chunksSize)
+    {
+      size_t newSize = stk->chunksSize ? stk->chunksSize : 1;
+
+      while (newSize < newCount)
+        newSize *= 2;
+
+      Element **chunks = nullptr;
+
+      if (stk->chunks)
+        {
+          removeKnownRange(stk->chunks);
 
-  *(CANARY *)stk->array = LEFT_ARRAY_CANARY;
+          chunks = (Element **) stk->allocator->reallocate(stk->allocator->context, stk->chunks,
+                                                           stk->chunksSize * sizeof(Element *),
+                                                           newSize * sizeof(Element *), alignof(Element *));
+        }
+      else
+        chunks = (Element **) stk->allocator->allocate(stk->allocator->context, newSize * sizeof(Element *),
+                                                       alignof(Element *));
 
-  stk->array = (Element *)((char *)stk->array + sizeof(CANARY));
+      if (!chunks)
+        {
+          if (stk->chunks)
+            addKnownRange(stk->chunks, stk->chunksSize * sizeof(Element *));
+
+          return 0;
+        }
+
+      addKnownRange(chunks, newSize * sizeof(Element *));
+
+      stk->chunks     = chunks;
+      stk->chunksSize = newSize;
+    }
+
+  for (size_t i = oldCount; i < newCount; ++i)
+    {
+      Element *chunk = stk->spareChunk;
 
-  *(CANARY *)(stk->array + size) = RIGHT_ARRAY_CANARY;
+      stk->spareChunk = nullptr;
+
+      if (!chunk)
+        chunk = allocBlock(stk, stk->chunkElements);
+
+      if (!chunk)
+        {
+          while (i-- > oldCount)
+            releaseChunk(stk, stk->chunks[i]);
+
+          return 0;
+        }
+
+      stk->chunks[i] = chunk;
+    }
+
+  for (size_t i = newCount; i < oldCount; ++i)
+    releaseChunk(stk, stk->chunks[i]);
+
+  return 1;
+}
+
+static void releaseChunk(Stack *stk, Element *chunk)
+{
+  if (!stk->spareChunk)
+    stk->spareChunk = chunk;
+  else
+    freeBlock(stk, chunk, stk->chunkElements);
+}
+
+static size_t runLength(const Stack *stk, size_t index)
+{
+  if (!stk->chunkElements)
+    return SIZE_MAX - index;
+
+  return stk->chunkElements - (index & (stk->chunkElements - 1));
+}
+
+static size_t growCapacity(const Stack *stk, size_t size)
+{
+  if (stk->chunkElements)
+    return (size + stk->chunkElements - 1) >> stk->chunkShift << stk->chunkShift;
+
+  size_t newCapacity = stk->capacity ? stk->capacity : stk->growth.minCapacity;
+
+  while (newCapacity < size)
+    newCapacity *= stk->growth.growthFactor;
+
+  return newCapacity;
+}
+
+static size_t shrinkCapacity(const Stack *stk, size_t capacity)
+{
+  if (stk->growth.neverShrink)
+    return capacity;
+
+  if (stk->chunkElements)
+    {
+      size_t used = stk->lastElementIndex > stk->reservedCapacity ? stk->lastElementIndex : stk->reservedCapacity;
+
+      size_t newCapacity = (used + stk->chunkElements - 1) >> stk->chunkShift << stk->chunkShift;
+
+      return newCapacity < capacity ? newCapacity : capacity;
+    }
+
+  if (stk->lastElementIndex * stk->growth.shrinkDivider > capacity)
+    return capacity;
+
+  size_t newCapacity = capacity / stk->growth.growthFactor;
+
+  if (newCapacity < stk->growth.minCapacity)
+    newCapacity = stk->growth.minCapacity;
+
+  if (newCapacity < stk->reservedCapacity)
+    newCapacity = stk->reservedCapacity;
+
+  if (newCapacity < stk->lastElementIndex)
+    newCapacity = stk->lastElementIndex;
+
+  return newCapacity < capacity ? newCapacity : capacity;
+}
+
+static void copyElements(Element *target, const Element *source, size_t count,
+                         void (*copyFunction)(Element *, const Element *))
+{
+  if constexpr (ElementStack::IS_TRIVIAL)
+    {
+      ElementStack::copySlots(target, source, count);
+
+      return;
+    }
+
+  for (size_t i = 0; i < count; ++i)
+    copyFunction(&target[i], &source[i]);
+}
+
+static void copyToSlots(Stack *stk, size_t from, const Element *elements, size_t count)
+{
+  while (count)
+    {
+      size_t run = runLength(stk, from) < count ? runLength(stk, from) : count;
+
+      copyElements(slotAt(stk, from), elements, run, stk->copyFunction);
+
+      from     += run;
+      elements += run;
+      count    -= run;
+    }
+}
+
+static void copyFromSlots(const Stack *stk, size_t from, Element *elements, size_t count)
+{
+  while (count)
+    {
+      size_t run = runLength(stk, from) < count ? runLength(stk, from) : count;
+
+      copyElements(elements, slotAt(stk, from), run, stk->copyFunction);
+
+      from     += run;
+      elements += run;
+      count    -= run;
+    }
+}
+
+#if !defined(RELEASE_BUILD_) && defined(INCREMENTAL_HASH_)
+
+static unsigned slotsHash(const Stack *stk, size_t from, size_t count)
+{
+  unsigned hash = 0;
+
+  while (count)
+    {
+      size_t run = runLength(stk, from) < count ? runLength(stk, from) : count;
+
+      hash += getArrayHash(slotAt(stk, from), run, sizeof(Element), stk->hashFamily, from);
+
+      from  += run;
+      count -= run;
+    }
+
+  return hash;
+}
 
 #endif
 
-  Element poison = getPoison(&stk->array[0]);
+int stack_isPoisonSlot(const Stack *stk, size_t index)
+{
+  if (index < stk->lastElementIndex)
+    return 0;
+
+#ifdef LAZY_POISON_
+
+  if (index >= stk->poisonedFrom)
+    return 1;
+
+#endif
+
+  return ElementStack::isPoisonSlot(slotAt(stk, index));
+}
+
+static void fillPoison(Stack *stk, size_t from, size_t to)
+{
+  if (from >= to)
+    return;
+
+  Element poison = getPoison(slotAt(stk, from));
+
+  while (from < to)
+    {
+      size_t count = runLength(stk, from) < to - from ? runLength(stk, from) : to - from;
+
+      Element *slots = slotAt(stk, from);
+
+      if constexpr (ElementStack::IS_TRIVIAL)
+        ElementStack::fillPoison(slots, count);
+      else
+        for (size_t i = 0; i < count; ++i)
+          stk->copyFunction(&slots[i], &poison);
+
+      from += count;
+    }
+}
+
+static void freeSlots(Stack *stk, size_t from, size_t to)
+{
+#ifdef LAZY_POISON_
+
+  if (to == stk->poisonedFrom)
+    {
+      stk->poisonedFrom = from;
+
+      return;
+    }
+
+#endif
 
-  for (size_t i = 0; i < size; ++i)
-    stk->copyFunction(&stk->array[i], &poison);
+  fillPoison(stk, from, to);
 }
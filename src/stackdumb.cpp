@@ -32,7 +32,8 @@ const char *ERRORS_MESSAGE[] = {      // errCode - errName
   "Stack hasn`t a function name",     // 2^12    - NOT_FUNCTION_NAME
   "Stack hasn`t a correct line",      // 2^13    - INCORRECT_LINE
   "Stack hash is corrupted",          // 2^14    - DIFFERENT_HASH
-  "Stack`s array hash is corrupted"   // 2^15    - DIFFERENT_ARRAY_HASH
+  "Stack`s array hash is corrupted",  // 2^15    - DIFFERENT_ARRAY_HASH
+  "Poison border is out of stack"     // 2^16    - INCORRECT_POISON_BORDER
 };
 
 const char *STATUS_NAME[] = {
@@ -41,40 +42,57 @@ const char *STATUS_NAME[] = {
   "EMPTY"
 };
 
-/// Print errors` message
-/// @param [in] errorCode Code of errors
-/// @param [in] filePtr File for writing
-static void printErrors(unsigned errorCode, FILE *filePtr);
-
 /// Print Stack status into file
 /// @param [in] stk Pointer to stack
 /// @param [in] filePtr File for writing
 static void printStatus(const Stack *stk, FILE *filePtr);
 
+/// Print chunks of segmented stack one under other
+/// @param [in] stk Pointer to stack
+/// @param [in] filePtr File for writing
+static void printChunks(const Stack *stk, FILE *filePtr);
+
+/// Print slots of stack from one block of memory (array or chunk)
+/// @param [in] stk Pointer to stack
+/// @param [in] from First slot
+/// @param [in] to Slot after last
+/// @param [in] filePtr File for writing
+static void printSlots(const Stack *stk, size_t from, size_t to, FILE *filePtr);
+
 /// Print addresss of stack`s elements
 /// @param [in] stk Pointer to stack
+/// @param [in] from First slot
 /// @param [in] filePtr FIle for writing
-static void printAddress(const Stack *stk, FILE *filePtr);
+static void printAddress(const Stack *stk, size_t from, FILE *filePtr);
 
 /// Print border for stack array into file
 /// @param [in] stk Pointer to stack
+/// @param [in] from First slot
+/// @param [in] to Slot after last
 /// @param [in] filePtr File for writing
-static void printBorder(const Stack *stk, FILE *filePtr);
+static void printBorder(const Stack *stk, size_t from, size_t to, FILE *filePtr);
 
 /// Print line for stack array into file
 /// @param [in] stk Pointer to stack
+/// @param [in] from First slot
+/// @param [in] to Slot after last
 /// @param [in] filePtr File for writing
-static void printLine(const Stack *stk, FILE *filePtr);
+static void printLine(const Stack *stk, size_t from, size_t to, FILE *filePtr);
 
 /// Print values in stack array
 /// @param [in] stk Pointer to stack
+/// @param [in] from First slot
+/// @param [in] to Slot after last
 /// @param filePtr File for writing
-static void printValues(const Stack *stk, FILE *filePtr);
+static void printValues(const Stack *stk, size_t from, size_t to, FILE *filePtr);
 
 /// Print arror for stack array into file
 /// @param [in] stk  Pointer to stack
+/// @param [in] from First slot
+/// @param [in] to Slot after last
 /// @param [in] filePtr File for writing
-static void printArrow(const Stack *stk, FILE *filePtr);
+/// @note Arrow is printed only if top of stack is between from and to
+static void printArrow(const Stack *stk, size_t from, size_t to, FILE *filePtr);
 
 #endif
 
@@ -102,18 +120,21 @@ void do_stack_dump(const Stack *stk, unsigned errorCode, FILE *filePtr,
             stk->info.line);
 
   if (isPointerCorrect(stk))
-    fprintf(filePtr, "\nHash: %u Array hash: %u", stk->hash, stk->arrayHash);
+    fprintf(filePtr, "\nHash (%s): %u Array hash: %u",
+            hashFamilyName(stk->hashFamily), stk->hash, stk->arrayHash);
 
-  if (isPointerCorrect(stk) && isPointerCorrect(stk->array))
+  if (isPointerCorrect(stk) && (isPointerCorrect(stk->array) || isPointerCorrect(stk->chunks)))
     {
-      MAX_LENGTH    = maxElementLength(&stk->array[0]);
+      Element sample = {};
+
+      MAX_LENGTH    = maxElementLength(&sample);
 
       MIDDLE_LENGTH = (MAX_LENGTH + 1) / 2;
     }
 
   fputc('\n', filePtr);
 
-  printErrors(errorCode, filePtr);
+  printStackErrors(errorCode, filePtr);
 
   printStatus (stk, filePtr);
 
@@ -124,28 +145,28 @@ void do_stack_dump(const Stack *stk, unsigned errorCode, FILE *filePtr,
       return;
     }
 
-  printAddress(stk, filePtr);
-
-  printBorder (stk, filePtr);
-
-  printLine   (stk, filePtr);
-
-  printValues (stk, filePtr);
-
-  printLine   (stk, filePtr);
+  if (stk->chunkElements)
+    printChunks(stk, filePtr);
+  else if (isPointerCorrect(stk->array))
+    printSlots(stk, 0, stk->capacity, filePtr);
 
-  printBorder (stk, filePtr);
+  fputc('\n', filePtr);
 
-  printArrow  (stk, filePtr);
+  #else
 
-  fputc('\n', filePtr);
+  (void)stk;
+  (void)errorCode;
+  (void)filePtr;
+  (void)fileName;
+  (void)functionName;
+  (void)line;
 
   #endif
 }
 
 #ifndef RELEASE_BUILD_
 
-static void printErrors(unsigned errorCode, FILE *filePtr)
+void printStackErrors(unsigned errorCode, FILE *filePtr)
 {
   if (!errorCode)
     {
@@ -177,6 +198,17 @@ static void printStatus(const Stack *stk, FILE *filePtr)
           "Stack capacity", stk->capacity,
           "Stack size", stk->lastElementIndex);
 
+  fprintf(filePtr, "|%-27s|%6lu|\n|%-27s|%6lu|\n",
+          "Grow count", stk->growCount,
+          "Shrink count", stk->shrinkCount);
+
+#ifdef LAZY_POISON_
+
+  fprintf(filePtr, "|%-27s|%6lu|\n",
+          "Poisoned from", stk->poisonedFrom);
+
+#endif
+
   fprintf(filePtr, STATUS_BORDER "\n");
 
   for (unsigned i = 0; i < STATUS_COUNT; ++i)
@@ -185,29 +217,66 @@ static void printStatus(const Stack *stk, FILE *filePtr)
   fprintf(filePtr, STATUS_BORDER "\n");
 }
 
-static void printAddress(const Stack *stk, FILE *filePtr)
+static void printChunks(const Stack *stk, FILE *filePtr)
 {
-  if (!isPointerCorrect(stk->array))
+  fprintf(filePtr, "Chunks: %lu of %lu elements, directory %p (%lu), spare chunk %p\n",
+          stk->capacity >> stk->chunkShift, stk->chunkElements, stk->chunks, stk->chunksSize, stk->spareChunk);
+
+  if (!isPointerCorrect(stk->chunks))
     return;
 
-  int firstSize = elementLength(&stk->array[0]) < MIDDLE_LENGTH ?
+  for (size_t from = 0; from < stk->capacity; from += stk->chunkElements)
+    {
+      if (DUMP_LVL == DUMP_NOT_EMPTY && from > stk->lastElementIndex)
+        break;
+
+      fprintf(filePtr, "Chunk %lu: ", from >> stk->chunkShift);
+
+      if (!isPointerCorrect(stk->chunks[from >> stk->chunkShift]))
+        {
+          fprintf(filePtr, "%p is incorrect\n", stk->chunks[from >> stk->chunkShift]);
+
+          continue;
+        }
+
+      printSlots(stk, from, from + stk->chunkElements, filePtr);
+    }
+}
+
+static void printSlots(const Stack *stk, size_t from, size_t to, FILE *filePtr)
+{
+  printAddress(stk, from, filePtr);
+
+  printBorder (stk, from, to, filePtr);
+
+  printLine   (stk, from, to, filePtr);
+
+  printValues (stk, from, to, filePtr);
+
+  printLine   (stk, from, to, filePtr);
+
+  printBorder (stk, from, to, filePtr);
+
+  printArrow  (stk, from, to, filePtr);
+}
+
+static void printAddress(const Stack *stk, size_t from, FILE *filePtr)
+{
+  int firstSize = elementLength(stack_slot(stk, from)) < MIDDLE_LENGTH ?
     MIDDLE_LENGTH : MAX_LENGTH;
 
-  if (isPoison(&stk->array[0]))
+  if (stack_isPoisonSlot(stk, from))
     firstSize = POISON_LENGTH;
 
   fprintf(filePtr, "%p\n%*s|\n%*s|\n%*sV\n",
-          stk->array, firstSize, "", firstSize, "", firstSize, "");
+          stack_slot(stk, from), firstSize, "", firstSize, "", firstSize, "");
 }
 
-static void printBorder(const Stack *stk, FILE *filePtr)
+static void printBorder(const Stack *stk, size_t from, size_t to, FILE *filePtr)
 {
-  if (!isPointerCorrect(stk->array))
-    return;
-
   int skip = 0;
 
-  for (size_t i = 0; i < stk->capacity; ++i)
+  for (size_t i = from; i < to; ++i)
     {
       if (!skip)
         fputc('#', filePtr);
@@ -219,9 +288,9 @@ static void printBorder(const Stack *stk, FILE *filePtr)
           return;
         }
 
-      int size = elementLength(&stk->array[i]) < MIDDLE_LENGTH ? MIDDLE_LENGTH : MAX_LENGTH;
+      int size = elementLength(stack_slot(stk, i)) < MIDDLE_LENGTH ? MIDDLE_LENGTH : MAX_LENGTH;
 
-      if (isPoison(&stk->array[i]) && i >= stk->lastElementIndex)
+      if (stack_isPoisonSlot(stk, i))
         {
           if (DUMP_LVL == DUMP_NOT_POISON)
             {
@@ -250,14 +319,11 @@ static void printBorder(const Stack *stk, FILE *filePtr)
   fputc('\n', filePtr);
 } 
 
-static void printLine(const Stack *stk, FILE *filePtr)
+static void printLine(const Stack *stk, size_t from, size_t to, FILE *filePtr)
 {
-  if (!isPointerCorrect(stk->array))
-    return;
-
   int skip = 0;
 
-  for (size_t i = 0; i < stk->capacity; ++i)
+  for (size_t i = from; i < to; ++i)
     {
       if (!skip)
         fputc('|', filePtr);
@@ -271,9 +337,9 @@ static void printLine(const Stack *stk, FILE *filePtr)
 
       const char ch = i < stk->lastElementIndex ? ' ' : '=';
 
-      int size = elementLength(&stk->array[i]) < MIDDLE_LENGTH ? MIDDLE_LENGTH : MAX_LENGTH;
+      int size = elementLength(stack_slot(stk, i)) < MIDDLE_LENGTH ? MIDDLE_LENGTH : MAX_LENGTH;
 
-      if (isPoison(&stk->array[i]) && i >= stk->lastElementIndex)
+      if (stack_isPoisonSlot(stk, i))
         {
           if (DUMP_LVL == DUMP_NOT_POISON)
             {
@@ -303,14 +369,11 @@ static void printLine(const Stack *stk, FILE *filePtr)
   fputc('\n', filePtr);
 }
 
-static void printValues(const Stack *stk, FILE *filePtr)
+static void printValues(const Stack *stk, size_t from, size_t to, FILE *filePtr)
 {
-  if (!isPointerCorrect(stk->array))
-    return;
-
   int skip = 0;
 
-  for (size_t i = 0; i < stk->capacity; ++i)
+  for (size_t i = from; i < to; ++i)
     {
       if (DUMP_LVL == DUMP_NOT_EMPTY && i == stk->lastElementIndex)
         {
@@ -319,11 +382,11 @@ static void printValues(const Stack *stk, FILE *filePtr)
           return;
         }
 
-      int elementSize = elementLength(&stk->array[i]);
+      int elementSize = elementLength(stack_slot(stk, i));
 
       int size = elementSize < MIDDLE_LENGTH ? MIDDLE_LENGTH : MAX_LENGTH;
 
-      if (isPoison(&stk->array[i]) && i >= stk->lastElementIndex)
+      if (stack_isPoisonSlot(stk, i))
         {
           if (DUMP_LVL == DUMP_NOT_POISON)
             {
@@ -351,31 +414,31 @@ static void printValues(const Stack *stk, FILE *filePtr)
       for (int j = 0; j < size- elementSize; ++j)
         fputc(' ', filePtr);
 
-      printElement(&stk->array[i], filePtr);
+      printElement(stack_slot(stk, i), filePtr);
     }
 
   fprintf(filePtr, "|\n");
 }
 
-static void printArrow(const Stack *stk, FILE *filePtr)
+static void printArrow(const Stack *stk, size_t from, size_t to, FILE *filePtr)
 {
-  if (!isPointerCorrect(stk->array) || !stk->lastElementIndex)
+  if (stk->lastElementIndex <= from || stk->lastElementIndex > to)
     return;
 
   fputc('>', filePtr);
 
-  for (size_t i = 0; i < stk->lastElementIndex - 1; ++i)
+  for (size_t i = from; i < stk->lastElementIndex - 1; ++i)
     {
-      int size = elementLength(&stk->array[i]) < MIDDLE_LENGTH ? MIDDLE_LENGTH : MAX_LENGTH;
+      int size = elementLength(stack_slot(stk, i)) < MIDDLE_LENGTH ? MIDDLE_LENGTH : MAX_LENGTH;
 
-      if (isPoison(&stk->array[i])  && i >= stk->lastElementIndex)
+      if (stack_isPoisonSlot(stk, i))
         size = POISON_LENGTH;
 
       for (int j = 0; j < size + 1; ++j)
         fputc('>', filePtr);
     }
 
-  int size = elementLength(&stk->array[stk->lastElementIndex - 1]) < MIDDLE_LENGTH ? MIDDLE_LENGTH : MAX_LENGTH;
+  int size = elementLength(stack_slot(stk, stk->lastElementIndex - 1)) < MIDDLE_LENGTH ? MIDDLE_LENGTH : MAX_LENGTH;
 
   for (int j = 0; j < size - 1; ++j)
     fputc('>', filePtr);
@@ -383,4 +446,12 @@ static void printArrow(const Stack *stk, FILE *filePtr)
   fputc('^', filePtr);
 }
 
+#else
+
+void printStackErrors(unsigned errorCode, FILE *filePtr)
+{
+  (void)errorCode;
+  (void)filePtr;
+}
+
 #endif
@@ -4,6 +4,7 @@
 #include <unistd.h>
 #include <sys/stat.h>
 #include "systemlike.h"
+#include "addressmap.h"
 
 void *recalloc(void *pointer, size_t elements, size_t elementSize)
 {
@@ -22,6 +23,11 @@ int isPointerCorrect(const void *pointer)
   if (!pointer)
     return 0;
 
+  int isMapped = isAddressMapped(pointer);
+
+  if (isMapped != -1)
+    return isMapped;
+
   return write(1, pointer, 0) != -1;
 }
 
@@ -0,0 +1,68 @@
+#include <time.h>
+#include <string.h>
+#include "timestamp.h"
+
+/// Formatted second of one thread
+typedef struct {
+  time_t second;
+  char   date[TIMESTAMP_SIZE]; // Date till seconds: "Sun Oct 18 07:13:23"
+  char   year[TIMESTAMP_SIZE]; // Rest after seconds: " 2026"
+  size_t dateLength;
+  size_t yearLength;
+} TimestampCache;
+
+/// Format second to cache
+/// @param [out] cache Pointer to cache
+/// @param [in] second Second from Epoch
+static void formatSecond(TimestampCache *cache, time_t second);
+
+uint64_t getTimestamp(TIMESTAMP_PRECISION precision)
+{
+  timespec now = {};
+
+  clock_gettime(precision == TIMESTAMP_MICROSECONDS ? CLOCK_REALTIME : CLOCK_REALTIME_COARSE, &now);
+
+  return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+}
+
+size_t formatTimestamp(uint64_t time, char *buffer, TIMESTAMP_PRECISION precision)
+{
+  static thread_local TimestampCache cache = {-1, "", "", 0, 0};
+
+  time_t second = (time_t) (time / 1000000000u);
+
+  if (second != cache.second)
+    formatSecond(&cache, second);
+
+  memcpy(buffer, cache.date, cache.dateLength);
+
+  size_t length = cache.dateLength;
+
+  if (precision == TIMESTAMP_MICROSECONDS)
+    {
+      unsigned microseconds = (unsigned) (time % 1000000000u / 1000u);
+
+      buffer[length++] = '.';
+
+      for (size_t digit = 6; digit > 0; --digit, microseconds /= 10)
+        buffer[length + digit - 1] = (char) ('0' + microseconds % 10);
+
+      length += 6;
+    }
+
+  memcpy(buffer + length, cache.year, cache.yearLength + 1);
+
+  return length + cache.yearLength;
+}
+
+static void formatSecond(TimestampCache *cache, time_t second)
+{
+  tm date = {};
+
+  localtime_r(&second, &date);
+
+  cache->dateLength = strftime(cache->date, sizeof(cache->date), "%a %b %e %H:%M:%S", &date);
+  cache->yearLength = strftime(cache->year, sizeof(cache->year), " %Y", &date);
+
+  cache->second = second;
+}
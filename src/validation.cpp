@@ -0,0 +1,487 @@
+#include <pthread.h>
+#include <time.h>
+#include <atomic>
+#include "validation.h"
+#include "logging.h"
+#include "systemlike.h"
+
+const unsigned DEFAULT_VALIDATION_PERIOD   = 16;
+const unsigned DEFAULT_VALIDATION_INTERVAL = 100;
+
+const long MAX_VALIDATOR_SLEEP_NS = 10 * 1000 * 1000;
+
+const uint64_t STATS_BATCH_SIZE = 256;
+
+/// Entry of list of stacks for background thread
+typedef struct alignas(64) {
+  pthread_mutex_t lock;           // Held by background check and by writers which free array
+
+  std::atomic<const Stack *> stack;
+
+  std::atomic<unsigned> writers;  // Count of unfinished changes, including changes of stack which left slot
+  std::atomic<unsigned> version;  // Count of finished changes
+
+  unsigned dumpedVersion;         // Version which was dumped, so one error is dumped once
+} RegistryEntry;
+
+static RegistryEntry REGISTRY[VALIDATION_REGISTRY_SIZE];
+
+static pthread_once_t REGISTRY_ONCE = PTHREAD_ONCE_INIT;
+
+static pthread_mutex_t POLICY_LOCK = PTHREAD_MUTEX_INITIALIZER;
+
+static std::atomic<int>      MODE     {VALIDATE_ALWAYS};
+static std::atomic<unsigned> PERIOD   {DEFAULT_VALIDATION_PERIOD};
+static std::atomic<unsigned> INTERVAL {DEFAULT_VALIDATION_INTERVAL};
+
+static pthread_t        Validator = {};
+static std::atomic<int> ValidatorRunning {0};
+
+static std::atomic<int> RegistryUsers {0};
+
+static std::atomic<uint64_t> Requests    {0};
+static std::atomic<uint64_t> Validations {0};
+static std::atomic<uint64_t> Failures    {0};
+static std::atomic<uint64_t> BusySkips   {0};
+static std::atomic<uint64_t> Nanoseconds {0};
+
+/// Counters of one thread which aren`t added to global counters yet
+class StatsBatch {
+  public:
+    uint64_t requests;
+    uint64_t validations;
+    uint64_t nanoseconds;
+
+    StatsBatch() :
+      requests(0),
+      validations(0),
+      nanoseconds(0)
+      {}
+
+    ~StatsBatch()
+      {
+        flush();
+      }
+
+    /// Add counters to global counters and clear them
+    void flush()
+      {
+        Requests.fetch_add(requests, std::memory_order_relaxed);
+        Validations.fetch_add(validations, std::memory_order_relaxed);
+        Nanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+        requests    = 0;
+        validations = 0;
+        nanoseconds = 0;
+      }
+};
+
+static thread_local StatsBatch STATS_BATCH;
+
+/// Init mutexes of REGISTRY
+static void initRegistry();
+
+/// Check that background thread checks stack
+/// @param [in] stk Pointer to stack
+/// @return 1 if stack is in list of background thread or 0 if it isn`t
+static int isRegistered(const Stack *stk);
+
+/// Get next pseudo-random number of this thread
+/// @return Random number
+static uint32_t nextRandom();
+
+/// Get monotonic time
+/// @return Time in nanoseconds
+static uint64_t getNanoseconds();
+
+/// Body of background thread
+/// @param [in] arg Unused
+/// @return nullptr
+static void *validatorLoop(void *arg);
+
+/// Check all registered stacks once
+static void validatorPass();
+
+void validation_setPolicy(const ValidationPolicy *policy, unsigned *error)
+{
+  if (!isPointerCorrect(policy) || policy->mode < VALIDATE_ALWAYS || policy->mode > VALIDATE_BACKGROUND)
+    {
+      if (isPointerCorrect(error))
+        *error = 1;
+
+      return;
+    }
+
+  pthread_mutex_lock(&POLICY_LOCK);
+
+  if (ValidatorRunning.load() && policy->mode != VALIDATE_BACKGROUND)
+    {
+      ValidatorRunning.store(0);
+
+      pthread_join(Validator, nullptr);
+
+      validation_releaseRegistry();
+    }
+
+  PERIOD.store(policy->period ? policy->period : DEFAULT_VALIDATION_PERIOD);
+  INTERVAL.store(policy->intervalMs ? policy->intervalMs : DEFAULT_VALIDATION_INTERVAL);
+  MODE.store(policy->mode);
+
+  if (!ValidatorRunning.load() && policy->mode == VALIDATE_BACKGROUND)
+    {
+      validation_retainRegistry();
+
+      ValidatorRunning.store(1);
+
+      if (pthread_create(&Validator, nullptr, validatorLoop, nullptr))
+        {
+          ValidatorRunning.store(0);
+
+          validation_releaseRegistry();
+
+          MODE.store(VALIDATE_ALWAYS);
+
+          if (isPointerCorrect(error))
+            *error = 1;
+        }
+    }
+
+  pthread_mutex_unlock(&POLICY_LOCK);
+}
+
+void validation_getPolicy(ValidationPolicy *policy)
+{
+  if (!isPointerCorrect(policy))
+    return;
+
+  policy->mode       = (VALIDATION_MODE)MODE.load();
+  policy->period     = PERIOD.load();
+  policy->intervalMs = INTERVAL.load();
+}
+
+void validation_stats(ValidationStats *stats)
+{
+  if (!isPointerCorrect(stats))
+    return;
+
+  STATS_BATCH.flush();
+
+  stats->requests    = Requests.load();
+  stats->validations = Validations.load();
+  stats->failures    = Failures.load();
+  stats->busySkips   = BusySkips.load();
+  stats->nanoseconds = Nanoseconds.load();
+}
+
+void validation_resetStats()
+{
+  STATS_BATCH.requests    = 0;
+  STATS_BATCH.validations = 0;
+  STATS_BATCH.nanoseconds = 0;
+
+  Requests.store(0);
+  Validations.store(0);
+  Failures.store(0);
+  BusySkips.store(0);
+  Nanoseconds.store(0);
+}
+
+int validation_shouldCheck(VALIDATION_POINT point, const Stack *stk)
+{
+  static thread_local unsigned callCounter = 0;
+
+  if (++STATS_BATCH.requests == STATS_BATCH_SIZE)
+    STATS_BATCH.flush();
+
+  switch ((VALIDATION_MODE)MODE.load(std::memory_order_relaxed))
+    {
+      case VALIDATE_ALWAYS:
+        return 1;
+
+      case VALIDATE_EVERY_NTH:
+        return point == VALIDATION_RESIZE ||
+               ++callCounter % PERIOD.load(std::memory_order_relaxed) == 0;
+
+      case VALIDATE_RANDOM:
+        return point == VALIDATION_RESIZE ||
+               nextRandom() % PERIOD.load(std::memory_order_relaxed) == 0;
+
+      case VALIDATE_ON_RESIZE:
+        return point == VALIDATION_RESIZE;
+
+      case VALIDATE_BACKGROUND:
+        return !isRegistered(stk);
+
+      default:
+        return 1;
+    }
+}
+
+unsigned validation_check(const Stack *stk)
+{
+  uint64_t start = getNanoseconds();
+
+  unsigned errorCode = stack_valid(stk);
+
+  STATS_BATCH.nanoseconds += getNanoseconds() - start;
+  STATS_BATCH.validations += 1;
+
+  if (errorCode)
+    Failures.fetch_add(1, std::memory_order_relaxed);
+
+  return errorCode;
+}
+
+void validation_retainRegistry()
+{
+  pthread_once(&REGISTRY_ONCE, initRegistry);
+
+  RegistryUsers.fetch_add(1);
+}
+
+void validation_releaseRegistry()
+{
+  if (RegistryUsers.fetch_sub(1) != 1)
+    return;
+
+  // Stacks which weren`t destroyed mustn`t stay in list till next user
+  for (int i = 0; i < VALIDATION_REGISTRY_SIZE; ++i)
+    {
+      pthread_mutex_lock(&REGISTRY[i].lock);
+
+      if (!RegistryUsers.load())
+        REGISTRY[i].stack.store(nullptr);
+
+      pthread_mutex_unlock(&REGISTRY[i].lock);
+    }
+}
+
+int validation_register(const Stack *stk)
+{
+  if (!RegistryUsers.load())
+    return -1;
+
+  for (int i = 0; i < VALIDATION_REGISTRY_SIZE; ++i)
+    {
+      if (REGISTRY[i].stack)
+        continue;
+
+      pthread_mutex_lock(&REGISTRY[i].lock);
+
+      if (!REGISTRY[i].stack)
+        {
+          REGISTRY[i].writers.fetch_add(1);
+          REGISTRY[i].dumpedVersion = REGISTRY[i].version.load() - 1;
+          REGISTRY[i].stack.store(stk);
+
+          pthread_mutex_unlock(&REGISTRY[i].lock);
+
+          return i;
+        }
+
+      pthread_mutex_unlock(&REGISTRY[i].lock);
+    }
+
+  logError(Validation registry is full and stack is checked inline);
+
+  return -1;
+}
+
+void validation_unregister(const Stack *stk)
+{
+  if (!stk)
+    return;
+
+  for (int i = 0; i < VALIDATION_REGISTRY_SIZE; ++i)
+    {
+      if (REGISTRY[i].stack.load(std::memory_order_relaxed) != stk)
+        continue;
+
+      pthread_mutex_lock(&REGISTRY[i].lock);
+
+      if (REGISTRY[i].stack.load() == stk)
+        REGISTRY[i].stack.store(nullptr);
+
+      pthread_mutex_unlock(&REGISTRY[i].lock);
+    }
+}
+
+int validation_beginWrite(int slot, const Stack *stk, int lock)
+{
+  // Slot of stack which was removed from list can belong to other stack now
+  if (slot < 0 || slot >= VALIDATION_REGISTRY_SIZE ||
+      REGISTRY[slot].stack.load(std::memory_order_relaxed) != stk)
+    return 0;
+
+  if (lock)
+    pthread_mutex_lock(&REGISTRY[slot].lock);
+
+  REGISTRY[slot].writers.fetch_add(1);
+
+  return 1;
+}
+
+void validation_endWrite(int slot, int lock)
+{
+  if (slot < 0 || slot >= VALIDATION_REGISTRY_SIZE)
+    return;
+
+  REGISTRY[slot].version.fetch_add(1);
+  REGISTRY[slot].writers.fetch_sub(1);
+
+  if (lock)
+    pthread_mutex_unlock(&REGISTRY[slot].lock);
+}
+
+const Stack *validation_lockStack(int slot, unsigned *version)
+{
+  if (slot < 0 || slot >= VALIDATION_REGISTRY_SIZE)
+    return nullptr;
+
+  pthread_once(&REGISTRY_ONCE, initRegistry);
+
+  pthread_mutex_lock(&REGISTRY[slot].lock);
+
+  *version = REGISTRY[slot].version.load();
+
+  if (REGISTRY[slot].writers.load())
+    return nullptr;
+
+  return REGISTRY[slot].stack.load();
+}
+
+int validation_isUnchanged(int slot, unsigned version)
+{
+  if (slot < 0 || slot >= VALIDATION_REGISTRY_SIZE)
+    return 0;
+
+  // Fields of stack were read by plain loads, they mustn`t move after check of version
+  std::atomic_thread_fence(std::memory_order_acquire);
+
+  return !REGISTRY[slot].writers.load() && REGISTRY[slot].version.load() == version;
+}
+
+void validation_unlockStack(int slot)
+{
+  if (slot < 0 || slot >= VALIDATION_REGISTRY_SIZE)
+    return;
+
+  pthread_mutex_unlock(&REGISTRY[slot].lock);
+}
+
+static void initRegistry()
+{
+  for (int i = 0; i < VALIDATION_REGISTRY_SIZE; ++i)
+    {
+      pthread_mutex_init(&REGISTRY[i].lock, nullptr);
+
+      REGISTRY[i].stack.store(nullptr);
+      REGISTRY[i].writers.store(0);
+    }
+}
+
+static int isRegistered(const Stack *stk)
+{
+#ifndef RELEASE_BUILD_
+
+  if (!stk)
+    return 0;
+
+  int slot = stk->validationSlot;
+
+  return slot >= 0 && slot < VALIDATION_REGISTRY_SIZE &&
+         REGISTRY[slot].stack.load(std::memory_order_relaxed) == stk;
+
+#else
+
+  (void)stk;
+
+  return 0;
+
+#endif
+}
+
+static uint32_t nextRandom()
+{
+  static thread_local uint32_t state = 0;
+
+  if (!state)
+    state = (uint32_t)getNanoseconds() | 1u;
+
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+
+  return state;
+}
+
+static uint64_t getNanoseconds()
+{
+  timespec now = {};
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static void *validatorLoop(void *)
+{
+  while (ValidatorRunning.load())
+    {
+      validatorPass();
+
+      long sleepLeft = (long)INTERVAL.load() * 1000000;
+
+      while (sleepLeft > 0 && ValidatorRunning.load())
+        {
+          timespec pause = {0, sleepLeft < MAX_VALIDATOR_SLEEP_NS ? sleepLeft : MAX_VALIDATOR_SLEEP_NS};
+
+          nanosleep(&pause, nullptr);
+
+          sleepLeft -= pause.tv_nsec;
+        }
+    }
+
+  return nullptr;
+}
+
+static void validatorPass()
+{
+  for (int i = 0; i < VALIDATION_REGISTRY_SIZE && ValidatorRunning.load(); ++i)
+    {
+      if (!REGISTRY[i].stack.load())
+        continue;
+
+      unsigned version = 0;
+
+      const Stack *stk = validation_lockStack(i, &version);
+
+      if (stk)
+        {
+          uint64_t start = getNanoseconds();
+
+          unsigned errorCode = stack_valid(stk);
+
+          Nanoseconds.fetch_add(getNanoseconds() - start, std::memory_order_relaxed);
+          Validations.fetch_add(1, std::memory_order_relaxed);
+
+          if (!validation_isUnchanged(i, version))
+            BusySkips.fetch_add(1, std::memory_order_relaxed);
+          else if (errorCode)
+            {
+              Failures.fetch_add(1, std::memory_order_relaxed);
+
+              if (REGISTRY[i].dumpedVersion != version)
+                {
+                  stack_dump(stk, errorCode, getLogFile());
+                }
+
+              REGISTRY[i].dumpedVersion = version;
+            }
+        }
+      else if (REGISTRY[i].stack.load())
+        BusySkips.fetch_add(1, std::memory_order_relaxed);
+
+      validation_unlockStack(i);
+    }
+}
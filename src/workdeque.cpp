@@ -0,0 +1,564 @@
+#include <stdlib.h>
+#include <new>
+#include "workdeque.h"
+#include "elementfunctions.h"
+#include "systemlike.h"
+#include "logging.h"
+
+#pragma GCC diagnostic ignored "-Wcast-qual"
+
+#ifndef RELEASE_BUILD_
+
+#define CHECK_VALID(DEQUE_POINTER, ERROR, ...)                          \
+  do                                                                    \
+    {                                                                   \
+      unsigned ERROR_CODE_TEMP = workdeque_valid(DEQUE_POINTER);        \
+                                                                        \
+      if (ERROR_CODE_TEMP)                                              \
+        {                                                               \
+          workdeque_dump(DEQUE_POINTER, ERROR_CODE_TEMP, getLogFile()); \
+                                                                        \
+          if (ERROR)                                                    \
+            *ERROR = ERROR_CODE_TEMP;                                   \
+                                                                        \
+          return __VA_ARGS__;                                           \
+        }                                                               \
+    } while (0)
+
+#else
+
+#define CHECK_VALID(DEQUE_POINTER, ERROR, ...) ;
+
+#endif
+
+const size_t DEFAULT_DEQUE_CAPACITY = 32;
+
+#ifndef RELEASE_BUILD_
+
+/// Place before elements, left canary is in its end, so elements start at ARRAY_ALIGNMENT
+const size_t DEQUE_HEADER_SIZE = ARRAY_ALIGNMENT;
+
+#endif
+
+/// Create circular array with poisoned slots
+/// @param [in] capacity Capacity of array, power of two
+/// @return Pointer to array or nullptr if was error
+static DequeArray *createDequeArray(size_t capacity);
+
+/// Free one circular array
+/// @param [in] array Pointer to array
+static void freeDequeArray(DequeArray *array);
+
+/// Free old arrays if no thief can read them
+/// @param [in/out] dq Pointer to deque
+/// @param [in/out] array Current array of deque
+/// @note Call only from owner thread
+static void freePreviousArrays(WorkDeque *dq, DequeArray *array);
+
+/// Get size of memory of elements of array
+/// @param [in] capacity Count of elements
+/// @return Size with canaries in bytes
+static size_t dequeBlockSize(size_t capacity);
+
+/// Create array twice bigger and copy elements from top to bottom into it
+/// @param [in] array Old array
+/// @param [in] top Index of top
+/// @param [in] bottom Index of bottom
+/// @return Pointer to new array or nullptr if was error
+static DequeArray *growDequeArray(DequeArray *array, int64_t top, int64_t bottom);
+
+/// Get slot of circular array
+/// @param [in] array Pointer to array
+/// @param [in] index Index of element in deque
+/// @return Pointer to slot
+static inline std::atomic<Element> *dequeSlot(const DequeArray *array, int64_t index);
+
+unsigned workdeque_valid(const WorkDeque *dq)
+{
+#ifdef RELEASE_BUILD_
+
+  (void)dq;
+
+  return 0;
+
+#else
+
+  if (!isPointerCorrect(dq))
+    return NULL_STACK_POINTER;
+
+  unsigned error = 0;
+
+  if (!(dq->status & INIT) && (dq->status & DESTROY))
+    error |= DESTROY_WITHOUT_INIT;
+
+  if (dq->leftCanary != LEFT_CANARY)
+    error |= LEFT_CANARY_DIED;
+
+  if (dq->rightCanary != RIGHT_CANARY)
+    error |= RIGHT_CANARY_DIED;
+
+  // Check can be called from thief, so array mustn`t be freed while it is read
+  dq->thieves.fetch_add(1, std::memory_order_seq_cst);
+
+  const DequeArray *array = dq->array.load(std::memory_order_seq_cst);
+
+  int hasStorage = isPointerCorrect(array) && isPointerCorrect(array->elements);
+
+  if (!hasStorage && (dq->status & INIT) && !(dq->status & DESTROY))
+    error |= NULL_ARRAY_POINTER;
+
+  if (hasStorage)
+    {
+      if (*(const CANARY *)((const char *)array->elements - sizeof(CANARY)) != LEFT_ARRAY_CANARY)
+        error |= LEFT_ARRAY_CANARY_DIED;
+
+      if (*(const CANARY *)(array->elements + array->capacity) != RIGHT_ARRAY_CANARY)
+        error |= RIGHT_ARRAY_CANARY_DIED;
+
+      int64_t size = dq->bottom.load(std::memory_order_relaxed) - dq->top.load(std::memory_order_relaxed);
+
+      if (size > (int64_t)array->capacity)
+        error |= CAPACITY_LESS_THAN_SIZE;
+    }
+
+  dq->thieves.fetch_sub(1, std::memory_order_release);
+
+  if (!isPointerCorrect(dq->info.name))
+    error |= NOT_NAME;
+
+  if (!isPointerCorrect(dq->info.fileName))
+    error |= NOT_FILE_NAME;
+
+  if (!isPointerCorrect(dq->info.functionName))
+    error |= NOT_FUNCTION_NAME;
+
+  if (dq->info.line <= 0)
+    error |= INCORRECT_LINE;
+
+  return error;
+
+#endif
+}
+
+void do_workdeque_init(WorkDeque *dq, size_t capacity,
+                       const char *name, const char *fileName, const char *functionName, int line,
+                       unsigned *error)
+{
+  if (!isPointerCorrect(dq) || !isPointerCorrect(name) || !isPointerCorrect(fileName) || !isPointerCorrect(functionName) || (line <= 0) || (dq->status & INIT))
+    {
+      if (isPointerCorrect(error))
+        *error = 1;
+
+      return;
+    }
+
+  size_t realCapacity = DEFAULT_DEQUE_CAPACITY;
+
+  while (realCapacity < capacity)
+    realCapacity *= 2;
+
+  DequeArray *array = createDequeArray(realCapacity);
+
+  if (!array)
+    {
+      if (isPointerCorrect(error))
+        *error = 1;
+
+      return;
+    }
+
+#ifndef RELEASE_BUILD_
+
+  dq->leftCanary  = LEFT_CANARY;
+  dq->rightCanary = RIGHT_CANARY;
+
+  dq->info.name         = name;
+  dq->info.fileName     = fileName;
+  dq->info.functionName = functionName;
+  dq->info.line         = line;
+
+#endif
+
+  dq->status = INIT;
+
+  dq->top    .store(0, std::memory_order_relaxed);
+  dq->bottom .store(0, std::memory_order_relaxed);
+  dq->thieves.store(0, std::memory_order_relaxed);
+  dq->array  .store(array, std::memory_order_release);
+
+  CHECK_VALID(dq, error);
+}
+
+void workdeque_destroy(WorkDeque *dq, unsigned *error)
+{
+  CHECK_VALID(dq, error);
+
+  (void)error;
+
+  DequeArray *array = dq->array.load(std::memory_order_relaxed);
+
+  while (array)
+    {
+      DequeArray *previous = array->previous;
+
+      freeDequeArray(array);
+
+      array = previous;
+    }
+
+  dq->array .store(nullptr, std::memory_order_relaxed);
+  dq->top   .store(0, std::memory_order_relaxed);
+  dq->bottom.store(0, std::memory_order_relaxed);
+
+  dq->status |= DESTROY;
+}
+
+void workdeque_push(WorkDeque *dq, const Element *element, unsigned *error)
+{
+  CHECK_VALID(dq, error);
+
+  if (!element)
+    {
+      if (error)
+        *error = 1;
+
+      return;
+    }
+
+  int64_t bottom = dq->bottom.load(std::memory_order_relaxed);
+  int64_t top    = dq->top   .load(std::memory_order_acquire);
+
+  DequeArray *array = dq->array.load(std::memory_order_relaxed);
+
+  if (bottom - top >= (int64_t)array->capacity)
+    {
+      DequeArray *newArray = growDequeArray(array, top, bottom);
+
+      if (!newArray)
+        {
+          if (error)
+            *error = 1;
+
+          return;
+        }
+
+      // Thief which isn`t counted yet will read new array, see workdeque_steal()
+      dq->array.store(newArray, std::memory_order_seq_cst);
+
+      array = newArray;
+    }
+
+  freePreviousArrays(dq, array);
+
+  dequeSlot(array, bottom)->store(*element, std::memory_order_relaxed);
+
+  std::atomic_thread_fence(std::memory_order_release);
+
+  dq->bottom.store(bottom + 1, std::memory_order_relaxed);
+
+  CHECK_VALID(dq, error);
+}
+
+void workdeque_pop(WorkDeque *dq, Element *element, unsigned *error)
+{
+  CHECK_VALID(dq, error);
+
+  if (!element)
+    {
+      if (error)
+        *error = 1;
+
+      return;
+    }
+
+  int64_t bottom = dq->bottom.load(std::memory_order_relaxed) - 1;
+
+  DequeArray *array = dq->array.load(std::memory_order_relaxed);
+
+  dq->bottom.store(bottom, std::memory_order_relaxed);
+
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  int64_t top = dq->top.load(std::memory_order_relaxed);
+
+  if (top > bottom)
+    {
+      dq->bottom.store(bottom + 1, std::memory_order_relaxed);
+
+      if (error)
+        *error = 1;
+
+      return;
+    }
+
+  Element value = dequeSlot(array, bottom)->load(std::memory_order_relaxed);
+
+  if (top == bottom)
+    {
+      int isTaken = dq->top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                                    std::memory_order_relaxed);
+
+      dq->bottom.store(bottom + 1, std::memory_order_relaxed);
+
+      if (!isTaken)
+        {
+          if (error)
+            *error = 1;
+
+          return;
+        }
+    }
+#ifndef RELEASE_BUILD_
+  else
+    dequeSlot(array, bottom)->store(getPoison(&value), std::memory_order_relaxed);
+#endif
+
+  *element = value;
+
+  CHECK_VALID(dq, error);
+}
+
+int workdeque_steal(WorkDeque *dq, Element *element, unsigned *error)
+{
+  CHECK_VALID(dq, error, STEAL_EMPTY);
+
+  if (!element)
+    {
+      if (error)
+        *error = 1;
+
+      return STEAL_EMPTY;
+    }
+
+  int64_t top = dq->top.load(std::memory_order_acquire);
+
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  int64_t bottom = dq->bottom.load(std::memory_order_acquire);
+
+  if (top >= bottom)
+    return STEAL_EMPTY;
+
+  // Owner frees old arrays only when count of thieves is zero after new array is stored,
+  // so array is read either while thief is counted or after it is stored
+  dq->thieves.fetch_add(1, std::memory_order_seq_cst);
+
+  DequeArray *array = dq->array.load(std::memory_order_seq_cst);
+
+  Element value = dequeSlot(array, top)->load(std::memory_order_relaxed);
+
+  dq->thieves.fetch_sub(1, std::memory_order_release);
+
+  if (!dq->top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                       std::memory_order_relaxed))
+    return STEAL_ABORT;
+
+  *element = value;
+
+  return STEAL_SUCCESS;
+}
+
+size_t workdeque_size(const WorkDeque *dq, unsigned *error)
+{
+  CHECK_VALID(dq, error, -1u);
+
+  (void)error;
+
+  int64_t size = dq->bottom.load(std::memory_order_relaxed) - dq->top.load(std::memory_order_relaxed);
+
+  return size > 0 ? (size_t)size : 0;
+}
+
+void do_workdeque_dump(const WorkDeque *dq, unsigned errorCode, FILE *filePtr,
+                       const char *fileName, const char *functionName, int line)
+{
+#ifndef RELEASE_BUILD_
+
+  if (!isPointerCorrect(filePtr))
+    filePtr = stdout;
+
+  fputc('\n', filePtr);
+
+  fprintf(filePtr, "%s at %s (%d):\n",
+          isPointerCorrect(functionName) ? functionName : "nullptr",
+          isPointerCorrect(fileName)     ? fileName     : "nullptr",
+          line);
+  fprintf(filePtr, "WorkDeque[%p]", (const void *)dq);
+
+  if (!isPointerCorrect(dq))
+    {
+      fputc('\n', filePtr);
+
+      printStackErrors(errorCode, filePtr);
+
+      return;
+    }
+
+  fprintf(filePtr, " \"%s\" at %s at %s (%d)\n",
+          isPointerCorrect(dq->info.name)         ? dq->info.name         : "nullptr",
+          isPointerCorrect(dq->info.functionName) ? dq->info.functionName : "nullptr",
+          isPointerCorrect(dq->info.fileName)     ? dq->info.fileName     : "nullptr",
+          dq->info.line);
+
+  printStackErrors(errorCode, filePtr);
+
+  int64_t top    = dq->top   .load(std::memory_order_relaxed);
+  int64_t bottom = dq->bottom.load(std::memory_order_relaxed);
+
+  dq->thieves.fetch_add(1, std::memory_order_seq_cst);
+
+  const DequeArray *array = dq->array.load(std::memory_order_seq_cst);
+
+  fprintf(filePtr, "Top: %ld Bottom: %ld Array: %p Capacity: %lu\n",
+          top, bottom, (const void *)array, isPointerCorrect(array) ? array->capacity : 0);
+
+  int hasStorage = isPointerCorrect(array) && isPointerCorrect(array->elements);
+
+  for (size_t i = 0; hasStorage && i < array->capacity; ++i)
+    {
+      Element value = array->elements[i].load(std::memory_order_relaxed);
+
+      int64_t distance = ((int64_t)i - top) & (int64_t)(array->capacity - 1);
+
+      fputc('|', filePtr);
+
+      if (distance >= bottom - top && isPoison(&value))
+        fprintf(filePtr, "POISON");
+      else
+        printElement(&value, filePtr);
+    }
+
+  dq->thieves.fetch_sub(1, std::memory_order_release);
+
+  if (hasStorage)
+    fprintf(filePtr, "|\n");
+
+#else
+
+  (void)dq;
+  (void)errorCode;
+  (void)filePtr;
+  (void)fileName;
+  (void)functionName;
+  (void)line;
+
+#endif
+}
+
+static DequeArray *createDequeArray(size_t capacity)
+{
+  DequeArray *array = (DequeArray *) calloc(1, sizeof(DequeArray));
+
+  if (!array)
+    return nullptr;
+
+  char *block = (char *) MALLOC_ALLOCATOR.allocate(MALLOC_ALLOCATOR.context, dequeBlockSize(capacity),
+                                                   ARRAY_ALIGNMENT);
+
+  if (!block)
+    {
+      free(array);
+
+      return nullptr;
+    }
+
+#ifndef RELEASE_BUILD_
+
+  array->elements = (std::atomic<Element> *)(block + DEQUE_HEADER_SIZE);
+
+  *(CANARY *)((char *)array->elements - sizeof(CANARY)) = LEFT_ARRAY_CANARY;
+  *(CANARY *)(array->elements + capacity)               = RIGHT_ARRAY_CANARY;
+
+  Element poison = getPoison(nullptr);
+
+#else
+
+  array->elements = (std::atomic<Element> *) block;
+
+  Element poison = {};
+
+#endif
+
+  for (size_t i = 0; i < capacity; ++i)
+    new (&array->elements[i]) std::atomic<Element>(poison);
+
+  array->capacity = capacity;
+  array->previous = nullptr;
+
+  return array;
+}
+
+static void freeDequeArray(DequeArray *array)
+{
+#ifndef RELEASE_BUILD_
+
+  void *block = (char *)array->elements - DEQUE_HEADER_SIZE;
+
+#else
+
+  void *block = array->elements;
+
+#endif
+
+  typedef std::atomic<Element> AtomicElement;
+
+  for (size_t i = 0; i < array->capacity; ++i)
+    array->elements[i].~AtomicElement();
+
+  MALLOC_ALLOCATOR.deallocate(MALLOC_ALLOCATOR.context, block, dequeBlockSize(array->capacity));
+
+  free(array);
+}
+
+static void freePreviousArrays(WorkDeque *dq, DequeArray *array)
+{
+  if (!array->previous || dq->thieves.load(std::memory_order_seq_cst))
+    return;
+
+  DequeArray *previous = array->previous;
+
+  array->previous = nullptr;
+
+  while (previous)
+    {
+      DequeArray *next = previous->previous;
+
+      freeDequeArray(previous);
+
+      previous = next;
+    }
+}
+
+static size_t dequeBlockSize(size_t capacity)
+{
+#ifndef RELEASE_BUILD_
+
+  return DEQUE_HEADER_SIZE + capacity*sizeof(std::atomic<Element>) + sizeof(CANARY);
+
+#else
+
+  return capacity*sizeof(std::atomic<Element>);
+
+#endif
+}
+
+static DequeArray *growDequeArray(DequeArray *array, int64_t top, int64_t bottom)
+{
+  DequeArray *newArray = createDequeArray(array->capacity * 2);
+
+  if (!newArray)
+    return nullptr;
+
+  for (int64_t i = top; i < bottom; ++i)
+    dequeSlot(newArray, i)->store(dequeSlot(array, i)->load(std::memory_order_relaxed),
+                                  std::memory_order_relaxed);
+
+  newArray->previous = array;
+
+  return newArray;
+}
+
+static inline std::atomic<Element> *dequeSlot(const DequeArray *array, int64_t index)
+{
+  return &array->elements[(size_t)index & (array->capacity - 1)];
+}
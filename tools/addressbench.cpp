@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "addressmap.h"
+#include "systemlike.h"
+
+const size_t BENCH_CHECKS      = 1000000;
+const size_t BENCH_RANGES      = 64;
+const size_t BENCH_BLOCK_SIZE  = 256;
+
+/// Check of pointer for benchmark
+typedef int (*PointerCheck)(const void *pointer);
+
+/// Check pointer as isPointerCorrect() did before map of addresses
+/// @param [in] pointer Pointer for check
+/// @return Is pointer correct
+static int writeProbe(const void *pointer);
+
+/// Measure time of check
+/// @param [in] name Name of case
+/// @param [in] check Function of check
+/// @param [in] pointers Array of checked pointers
+/// @param [in] count Count of pointers, they are checked in circle
+static void measure(const char *name, PointerCheck check, const void *const *pointers, size_t count);
+
+/// Get time of monotonic clock
+/// @return Time in nanoseconds
+static uint64_t getNanoseconds();
+
+int main()
+{
+  void *blocks[BENCH_RANGES] = {};
+
+  for (size_t i = 0; i < BENCH_RANGES; ++i)
+    {
+      blocks[i] = malloc(BENCH_BLOCK_SIZE);
+
+      if (!blocks[i])
+        {
+          fprintf(stderr, "Can`t allocate memory\n");
+
+          return 1;
+        }
+    }
+
+  refreshAddressMap();
+
+  printf("%-36s %10s\n", "Case", "ns/check");
+
+  measure("write(2) probe",              writeProbe,       blocks, BENCH_RANGES);
+  measure("isPointerCorrect, maps cache", isPointerCorrect, blocks, BENCH_RANGES);
+
+  // Anonymous mapping can be unmapped by others, so each hit in cache is checked by syscall
+  void *mapping = mmap(nullptr, BENCH_BLOCK_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  if (mapping != MAP_FAILED)
+    {
+      measure("isPointerCorrect, anonymous mapping", isPointerCorrect, &mapping, 1);
+
+      munmap(mapping, BENCH_BLOCK_SIZE);
+    }
+
+  for (size_t count = 1, added = 0; count <= BENCH_RANGES; count *= 4)
+    {
+      for (; added < count; ++added)
+        addKnownRange(blocks[added], BENCH_BLOCK_SIZE);
+
+      char name[64] = "";
+
+      snprintf(name, sizeof(name), "isPointerCorrect, %zu known range(s)", count);
+
+      measure(name, isPointerCorrect, blocks, count);
+    }
+
+  for (size_t i = 0; i < BENCH_RANGES; ++i)
+    {
+      removeKnownRange(blocks[i]);
+
+      free(blocks[i]);
+    }
+
+  return 0;
+}
+
+static int writeProbe(const void *pointer)
+{
+  return pointer && write(1, pointer, 0) != -1;
+}
+
+static void measure(const char *name, PointerCheck check, const void *const *pointers, size_t count)
+{
+  size_t correct = 0;
+
+  uint64_t start = getNanoseconds();
+
+  for (size_t i = 0; i < BENCH_CHECKS; ++i)
+    correct += (size_t) check(pointers[i % count]);
+
+  uint64_t elapsed = getNanoseconds() - start;
+
+  printf("%-36s %10.1f%s\n", name, (double) elapsed / (double) BENCH_CHECKS,
+         correct == BENCH_CHECKS ? "" : " (wrong result)");
+}
+
+static uint64_t getNanoseconds()
+{
+  timespec now = {};
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
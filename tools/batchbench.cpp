@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include "stack.h"
+
+const size_t BENCH_ELEMENTS  = 1024;
+const size_t BENCH_ROUNDS    = 1000;
+const size_t BENCH_BATCHES[] = {1, 4, 16, 64, 256, 1024};
+
+static int ELEMENTS[BENCH_ELEMENTS] = {};
+static int POPPED  [BENCH_ELEMENTS] = {};
+
+/// Copy int element
+/// @param [out] target Pointer to target element
+/// @param [in] source Pointer to source element
+static void copyInt(int *target, const int *source);
+
+/// Measure push and pop of BENCH_ELEMENTS elements by one element
+/// @param [in] batch Count of elements which are pushed before they are popped
+/// @param [out] sum Sum of popped elements in one round
+/// @return Time of one element operation in nanoseconds
+static double measureLoop(size_t batch, long long *sum);
+
+/// Measure push and pop of BENCH_ELEMENTS elements by stack_push_n() and stack_pop_n()
+/// @param [in] batch Count of elements in one call
+/// @param [out] sum Sum of popped elements in one round
+/// @return Time of one element operation in nanoseconds
+static double measureBatch(size_t batch, long long *sum);
+
+/// Get time of monotonic clock
+/// @return Time in nanoseconds
+static uint64_t getNanoseconds();
+
+int main()
+{
+  for (size_t i = 0; i < BENCH_ELEMENTS; ++i)
+    ELEMENTS[i] = (int)i;
+
+  printf("%-8s %14s %14s %10s\n", "Batch", "Loop, ns/op", "Batch, ns/op", "Speedup");
+
+  for (size_t batch : BENCH_BATCHES)
+    {
+      long long loopSum  = 0;
+      long long batchSum = 0;
+
+      double loop    = measureLoop (batch, &loopSum);
+      double batched = measureBatch(batch, &batchSum);
+
+      if (loopSum != batchSum)
+        {
+          printf("Different sums with batch %zu: %lld and %lld\n", batch, loopSum, batchSum);
+
+          return 1;
+        }
+
+      printf("%-8zu %14.2f %14.2f %10.2f\n", batch, loop, batched, loop / batched);
+    }
+
+  return 0;
+}
+
+static void copyInt(int *target, const int *source)
+{
+  *target = *source;
+}
+
+static double measureLoop(size_t batch, long long *sum)
+{
+  Stack stk = {};
+
+  stack_init(&stk, 0, copyInt);
+
+  *sum = 0;
+
+  uint64_t start = getNanoseconds();
+
+  for (size_t round = 0; round < BENCH_ROUNDS; ++round)
+    for (size_t first = 0; first < BENCH_ELEMENTS; first += batch)
+      {
+        for (size_t i = first; i < first + batch; ++i)
+          stack_push(&stk, &ELEMENTS[i]);
+
+        for (size_t i = 0; i < batch; ++i)
+          {
+            int element = 0;
+
+            stack_pop(&stk, &element);
+
+            *sum += element;
+          }
+      }
+
+  uint64_t elapsed = getNanoseconds() - start;
+
+  stack_destroy(&stk);
+
+  *sum /= (long long)BENCH_ROUNDS;
+
+  return (double)elapsed / (double)(2 * BENCH_ROUNDS * BENCH_ELEMENTS);
+}
+
+static double measureBatch(size_t batch, long long *sum)
+{
+  Stack stk = {};
+
+  stack_init(&stk, 0, copyInt);
+
+  *sum = 0;
+
+  uint64_t start = getNanoseconds();
+
+  for (size_t round = 0; round < BENCH_ROUNDS; ++round)
+    for (size_t first = 0; first < BENCH_ELEMENTS; first += batch)
+      {
+        stack_push_n(&stk, &ELEMENTS[first], batch);
+
+        stack_pop_n(&stk, POPPED, batch);
+
+        for (size_t i = 0; i < batch; ++i)
+          *sum += POPPED[i];
+      }
+
+  uint64_t elapsed = getNanoseconds() - start;
+
+  stack_destroy(&stk);
+
+  *sum /= (long long)BENCH_ROUNDS;
+
+  return (double)elapsed / (double)(2 * BENCH_ROUNDS * BENCH_ELEMENTS);
+}
+
+static uint64_t getNanoseconds()
+{
+  timespec now = {};
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
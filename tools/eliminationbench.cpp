@@ -0,0 +1,231 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <atomic>
+#include "eliminationstack.h"
+
+const int    MAX_THREADS      = 32;
+const int    BENCH_THREADS[]  = {8, 16, 32};
+const size_t BENCH_OPERATIONS = 2000000;
+const size_t BENCH_PREFILL    = 1024;
+
+/// Stacks which are compared in benchmark
+enum BENCH_TARGET {
+  BENCH_LOCKFREE,    // LockFreeStack
+  BENCH_ELIMINATION, // EliminationStack
+};
+
+/// Arguments of thread of benchmark
+typedef struct {
+  BENCH_TARGET      target;
+  LockFreeStack    *lockfree;
+  EliminationStack *elimination;
+  int               id;
+  size_t            operations;
+  size_t            empty;      // Pops from empty stack
+} BenchArgs;
+
+static std::atomic<int> Ready {0};
+static std::atomic<int> Go    {0};
+
+/// Copy int element
+/// @param [out] target Pointer to target element
+/// @param [in] source Pointer to source element
+static void copyInt(int *target, const int *source);
+
+/// Push or pop with equal probability in loop
+/// @param [in] bench Pointer to BenchArgs
+/// @return nullptr
+static void *benchThread(void *bench);
+
+/// Measure operations per second for count of threads
+/// @param [in] target Stack for benchmark
+/// @param [in] threads Count of threads
+/// @param [in] arenaSize Count of arena slots or 0 for default
+/// @param [in] backoff Count of spins in arena or 0 for default
+/// @param [out] eliminations Share of pushes which were finished in arena, can be nullptr
+/// @return Millions of operations per second
+static double runBench(BENCH_TARGET target, int threads, size_t arenaSize, unsigned backoff,
+                       double *eliminations);
+
+/// Start all threads at once
+/// @param [in] threads Count of threads
+static void waitForStart(int threads);
+
+/// Get next pseudo-random number
+/// @param [in/out] state State of generator, not zero
+/// @return Random number
+static uint32_t nextRandom(uint32_t *state);
+
+/// Get time of monotonic clock
+/// @return Time in nanoseconds
+static uint64_t getNanoseconds();
+
+int main(int argc, char *argv[])
+{
+  size_t   arenaSize = argc > 1 ? (size_t)atol(argv[1])   : 0;
+  unsigned backoff   = argc > 2 ? (unsigned)atoi(argv[2]) : 0;
+
+  printf("Arena size %zu, backoff %u\n", arenaSize ? arenaSize : DEFAULT_ARENA_SIZE,
+         backoff ? backoff : DEFAULT_BACKOFF);
+
+  printf("%-8s %16s %18s %14s\n", "Threads", "Lock-free, Mop/s", "Elimination, Mop/s", "Eliminated, %");
+
+  for (int threads : BENCH_THREADS)
+    {
+      double lockfree = runBench(BENCH_LOCKFREE, threads, arenaSize, backoff, nullptr);
+
+      double eliminations = 0;
+      double elimination  = runBench(BENCH_ELIMINATION, threads, arenaSize, backoff, &eliminations);
+
+      printf("%-8d %16.2f %18.2f %14.1f\n", threads, lockfree, elimination, eliminations * 100);
+    }
+
+  return 0;
+}
+
+static void copyInt(int *target, const int *source)
+{
+  *target = *source;
+}
+
+static double runBench(BENCH_TARGET target, int threads, size_t arenaSize, unsigned backoff,
+                       double *eliminations)
+{
+  LockFreeStack    lockfree    = {};
+  EliminationStack elimination = {};
+
+  size_t operations = BENCH_OPERATIONS / (size_t)threads;
+
+  // Every thread can push all its operations in the worst case
+  size_t capacity = BENCH_PREFILL + operations * (size_t)threads;
+
+  if (target == BENCH_LOCKFREE)
+    lockfree_init(&lockfree, capacity, copyInt);
+  else
+    elimination_init(&elimination, capacity, copyInt, arenaSize, backoff);
+
+  // Pops mustn`t often find empty stack, it isn`t contention which is measured
+  for (int i = 0; i < (int)BENCH_PREFILL; ++i)
+    if (target == BENCH_LOCKFREE)
+      lockfree_push(&lockfree, &i);
+    else
+      elimination_push(&elimination, &i);
+
+  size_t prefillEliminations = target == BENCH_ELIMINATION ? elimination_count(&elimination) : 0;
+
+  pthread_t ids [MAX_THREADS] = {};
+  BenchArgs args[MAX_THREADS] = {};
+
+  Ready.store(0);
+  Go.store(0);
+
+  for (int i = 0; i < threads; ++i)
+    {
+      args[i] = {target, &lockfree, &elimination, i, operations, 0};
+
+      pthread_create(&ids[i], nullptr, benchThread, &args[i]);
+    }
+
+  waitForStart(threads);
+
+  uint64_t start = getNanoseconds();
+
+  size_t empty = 0;
+
+  for (int i = 0; i < threads; ++i)
+    {
+      pthread_join(ids[i], nullptr);
+
+      empty += args[i].empty;
+    }
+
+  uint64_t elapsed = getNanoseconds() - start;
+
+  if (empty)
+    printf("%zu pops found empty stack\n", empty);
+
+  if (target == BENCH_LOCKFREE)
+    lockfree_destroy(&lockfree);
+  else
+    {
+      // About half of operations are pushes
+      if (eliminations)
+        *eliminations = (double)(elimination_count(&elimination) - prefillEliminations) * 2 /
+                        (double)(operations * (size_t)threads);
+
+      elimination_destroy(&elimination);
+    }
+
+  return (double)(operations * (size_t)threads) * 1e3 / (double)elapsed;
+}
+
+static void *benchThread(void *bench)
+{
+  BenchArgs *args = (BenchArgs *)bench;
+
+  uint32_t random = (uint32_t)(args->id + 1) * 2654435761u | 1u;
+
+  ++Ready;
+
+  while (!Go.load())
+    sched_yield();
+
+  for (size_t i = 0; i < args->operations; ++i)
+    {
+      int element = (int)i;
+
+      unsigned error = 0;
+
+      int isPush = nextRandom(&random) & 1;
+
+      if (args->target == BENCH_LOCKFREE)
+        {
+          if (isPush)
+            lockfree_push(args->lockfree, &element, &error);
+          else
+            lockfree_pop (args->lockfree, &element, &error);
+        }
+      else
+        {
+          if (isPush)
+            elimination_push(args->elimination, &element, &error);
+          else
+            elimination_pop (args->elimination, &element, &error);
+        }
+
+      if (error && !isPush)
+        ++args->empty;
+    }
+
+  return nullptr;
+}
+
+static void waitForStart(int threads)
+{
+  while (Ready.load() < threads)
+    sched_yield();
+
+  Go.store(1);
+}
+
+static uint32_t nextRandom(uint32_t *state)
+{
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+
+  return *state;
+}
+
+static uint64_t getNanoseconds()
+{
+  timespec now = {};
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
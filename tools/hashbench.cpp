@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include "conf.h"
+#include "hash.h"
+
+const size_t BENCH_BYTES = 256 * 1024 * 1024;
+const size_t SLOT_SIZE   = sizeof(Element);
+
+const size_t     BENCH_SIZES[]    = {64, 4 * 1024, 1024 * 1024, 64 * 1024 * 1024};
+const HASH_FAMILY BENCH_FAMILIES[] = {HASH_DJB, HASH_CRC32C, HASH_XXH32};
+
+/// Measure speed of hash of whole block and of position-weighted hash of its slots
+/// @param [in] data Block for hash
+/// @param [in] size Size of block
+/// @param [in] family Family of hash function
+/// @param [out] sink Hashes are added here, so they aren`t thrown away by compiler
+static void measure(const unsigned char *data, size_t size, HASH_FAMILY family, unsigned *sink);
+
+/// Get time of monotonic clock
+/// @return Time in nanoseconds
+static uint64_t getNanoseconds();
+
+int main()
+{
+  size_t maxSize = BENCH_SIZES[sizeof(BENCH_SIZES) / sizeof(BENCH_SIZES[0]) - 1];
+
+  unsigned char *data = (unsigned char *) malloc(maxSize);
+
+  if (!data)
+    {
+      fprintf(stderr, "Can`t allocate memory\n");
+
+      return 1;
+    }
+
+  for (size_t i = 0; i < maxSize; ++i)
+    data[i] = (unsigned char)(i * 131 + (i >> 8));
+
+  unsigned sink = 0;
+
+  printf("%-10s %-8s %14s %14s\n", "Size", "Family", "Whole, MB/s", "Slots, MB/s");
+
+  for (size_t size : BENCH_SIZES)
+    for (HASH_FAMILY family : BENCH_FAMILIES)
+      measure(data, size, family, &sink);
+
+  printf("Sink: %u\n", sink);
+
+  free(data);
+
+  return 0;
+}
+
+static void measure(const unsigned char *data, size_t size, HASH_FAMILY family, unsigned *sink)
+{
+  size_t repeats = BENCH_BYTES / size;
+
+  uint64_t start = getNanoseconds();
+
+  for (size_t i = 0; i < repeats; ++i)
+    *sink += getFamilyHash(data, size, family);
+
+  uint64_t whole = getNanoseconds() - start;
+
+  start = getNanoseconds();
+
+  for (size_t i = 0; i < repeats; ++i)
+    *sink += getArrayHash(data, size / SLOT_SIZE, SLOT_SIZE, family);
+
+  uint64_t slots = getNanoseconds() - start;
+
+  double megabytes = (double)(repeats * size) / (1024.0 * 1024.0);
+
+  printf("%-10zu %-8s %14.1f %14.1f\n", size, hashFamilyName(family),
+         megabytes * 1e9 / (double)whole, megabytes * 1e9 / (double)slots);
+}
+
+static uint64_t getNanoseconds()
+{
+  timespec now = {};
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
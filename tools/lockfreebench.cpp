@@ -0,0 +1,361 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <atomic>
+#include "lockfreestack.h"
+
+const int    MAX_THREADS        = 64;
+const size_t STRESS_OPERATIONS  = 200000;
+const size_t STRESS_BURST       = 16;
+const size_t STRESS_OUTSTANDING = 64;
+const size_t BENCH_OPERATIONS   = 1000000;
+
+/// Stacks which are compared in scaling benchmark
+enum BENCH_TARGET {
+  BENCH_LOCKFREE, // LockFreeStack
+  BENCH_MUTEX,    // Stack with global mutex around each call
+};
+
+/// Arguments of thread of stress test
+typedef struct {
+  LockFreeStack *stk;
+  int            id;
+  unsigned char *seen;     // Count of pops of every value
+  size_t         values;   // Count of values of all threads
+  size_t         failures; // Errors of push and pop which mustn`t be
+} StressArgs;
+
+/// Arguments of thread of benchmark
+typedef struct {
+  BENCH_TARGET   target;
+  LockFreeStack *lockfree;
+  Stack         *locked;
+  size_t         operations;
+} BenchArgs;
+
+static pthread_mutex_t STACK_LOCK = PTHREAD_MUTEX_INITIALIZER;
+
+static std::atomic<int> Ready {0};
+static std::atomic<int> Go    {0};
+
+/// Copy int element
+/// @param [out] target Pointer to target element
+/// @param [in] source Pointer to source element
+static void copyInt(int *target, const int *source);
+
+/// Push and pop unique values in random bursts, each value is counted when it is popped
+/// @param [in] stress Pointer to StressArgs
+/// @return nullptr
+static void *stressThread(void *stress);
+
+/// Check that each pushed value is popped once and stack isn`t broken
+/// @param [in] threads Count of threads
+/// @return 1 if test is passed or 0 if it isn`t
+static int runStress(int threads);
+
+/// Push and pop in loop
+/// @param [in] bench Pointer to BenchArgs
+/// @return nullptr
+static void *benchThread(void *bench);
+
+/// Measure operations per second for count of threads
+/// @param [in] target Stack for benchmark
+/// @param [in] threads Count of threads
+/// @return Millions of operations per second
+static double runBench(BENCH_TARGET target, int threads);
+
+/// Start all threads at once
+/// @param [in] threads Count of threads
+static void waitForStart(int threads);
+
+/// Get next pseudo-random number
+/// @param [in/out] state State of generator, not zero
+/// @return Random number
+static uint32_t nextRandom(uint32_t *state);
+
+/// Get time of monotonic clock
+/// @return Time in nanoseconds
+static uint64_t getNanoseconds();
+
+int main(int argc, char *argv[])
+{
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+
+  int maxThreads = argc > 1 ? atoi(argv[1]) : (int)(cores > 0 ? cores : 1);
+
+  if (maxThreads < 1 || maxThreads > MAX_THREADS)
+    {
+      fprintf(stderr, "Count of threads must be from 1 to %d\n", MAX_THREADS);
+
+      return 1;
+    }
+
+  int stressThreads = maxThreads < 4 ? 4 : maxThreads;
+
+  if (!runStress(stressThreads))
+    {
+      printf("Stress test with %d threads failed\n", stressThreads);
+
+      return 1;
+    }
+
+  printf("Stress test with %d threads passed\n", stressThreads);
+
+  printf("%-8s %16s %16s\n", "Threads", "Lock-free, Mop/s", "Mutex, Mop/s");
+
+  for (int threads = 1; ; threads *= 2)
+    {
+      if (threads > maxThreads)
+        threads = maxThreads;
+
+      printf("%-8d %16.2f %16.2f\n", threads,
+             runBench(BENCH_LOCKFREE, threads), runBench(BENCH_MUTEX, threads));
+
+      if (threads == maxThreads)
+        break;
+    }
+
+  return 0;
+}
+
+static void copyInt(int *target, const int *source)
+{
+  *target = *source;
+}
+
+static int runStress(int threads)
+{
+  LockFreeStack stk = {};
+
+  unsigned error = 0;
+
+  do_lockfree_init(&stk, (size_t)threads * STRESS_OUTSTANDING, copyInt, INIT_INFO(&stk), &error);
+
+  if (error)
+    return 0;
+
+  size_t values = (size_t)threads * STRESS_OPERATIONS;
+
+  unsigned char *seen = (unsigned char *) calloc(values, sizeof(unsigned char));
+
+  if (!seen)
+    return 0;
+
+  pthread_t  ids [MAX_THREADS] = {};
+  StressArgs args[MAX_THREADS] = {};
+
+  Ready.store(0);
+  Go.store(0);
+
+  for (int i = 0; i < threads; ++i)
+    {
+      args[i] = {&stk, i, seen, values, 0};
+
+      pthread_create(&ids[i], nullptr, stressThread, &args[i]);
+    }
+
+  waitForStart(threads);
+
+  size_t failures = 0;
+
+  for (int i = 0; i < threads; ++i)
+    {
+      pthread_join(ids[i], nullptr);
+
+      failures += args[i].failures;
+    }
+
+  while (!lockfree_isEmpty(&stk))
+    {
+      int element = 0;
+
+      lockfree_pop(&stk, &element, &error);
+
+      if (error || element < 0 || (size_t)element >= values)
+        return 0;
+
+      ++seen[element];
+    }
+
+  for (size_t i = 0; i < values; ++i)
+    if (seen[i] != 1)
+      ++failures;
+
+  failures += lockfree_valid(&stk) != 0;
+
+  lockfree_destroy(&stk);
+
+  free(seen);
+
+  return !failures;
+}
+
+static void *stressThread(void *stress)
+{
+  StressArgs *args = (StressArgs *)stress;
+
+  uint32_t random = (uint32_t)args->id * 2654435761u | 1u;
+
+  size_t pushed      = 0;
+  size_t outstanding = 0;
+
+  ++Ready;
+
+  while (!Go.load())
+    sched_yield();
+
+  while (pushed < STRESS_OPERATIONS)
+    {
+      size_t burst = nextRandom(&random) % STRESS_BURST + 1;
+
+      for (size_t i = 0; i < burst && pushed < STRESS_OPERATIONS && outstanding < STRESS_OUTSTANDING; ++i)
+        {
+          int element = (int)((size_t)args->id * STRESS_OPERATIONS + pushed);
+
+          unsigned error = 0;
+
+          lockfree_push(args->stk, &element, &error);
+
+          if (error)
+            ++args->failures;
+
+          ++pushed;
+          ++outstanding;
+        }
+
+      burst = nextRandom(&random) % STRESS_BURST + 1;
+
+      for (size_t i = 0; i < burst; ++i)
+        {
+          int element = 0;
+
+          unsigned error = 0;
+
+          lockfree_pop(args->stk, &element, &error);
+
+          // Stack can be empty for a moment, other threads pop too
+          if (error)
+            break;
+
+          if (element < 0 || (size_t)element >= args->values)
+            {
+              ++args->failures;
+
+              continue;
+            }
+
+          // Value is popped by one thread only, so counter isn`t shared
+          ++args->seen[element];
+
+          if (outstanding)
+            --outstanding;
+        }
+    }
+
+  return nullptr;
+}
+
+static double runBench(BENCH_TARGET target, int threads)
+{
+  LockFreeStack lockfree = {};
+  Stack         locked   = {};
+
+  size_t capacity = (size_t)threads * 2;
+
+  if (target == BENCH_LOCKFREE)
+    lockfree_init(&lockfree, capacity, copyInt);
+  else
+    stack_init(&locked, capacity, copyInt);
+
+  pthread_t ids [MAX_THREADS] = {};
+  BenchArgs args[MAX_THREADS] = {};
+
+  Ready.store(0);
+  Go.store(0);
+
+  for (int i = 0; i < threads; ++i)
+    {
+      args[i] = {target, &lockfree, &locked, BENCH_OPERATIONS / (size_t)threads};
+
+      pthread_create(&ids[i], nullptr, benchThread, &args[i]);
+    }
+
+  waitForStart(threads);
+
+  uint64_t start = getNanoseconds();
+
+  for (int i = 0; i < threads; ++i)
+    pthread_join(ids[i], nullptr);
+
+  uint64_t elapsed = getNanoseconds() - start;
+
+  if (target == BENCH_LOCKFREE)
+    lockfree_destroy(&lockfree);
+  else
+    stack_destroy(&locked);
+
+  return (double)(2 * args[0].operations * (size_t)threads) * 1e3 / (double)elapsed;
+}
+
+static void *benchThread(void *bench)
+{
+  BenchArgs *args = (BenchArgs *)bench;
+
+  ++Ready;
+
+  while (!Go.load())
+    sched_yield();
+
+  for (size_t i = 0; i < args->operations; ++i)
+    {
+      int element = (int)i;
+
+      if (args->target == BENCH_LOCKFREE)
+        {
+          lockfree_push(args->lockfree, &element);
+          lockfree_pop (args->lockfree, &element);
+        }
+      else
+        {
+          pthread_mutex_lock(&STACK_LOCK);
+          stack_push(args->locked, &element);
+          pthread_mutex_unlock(&STACK_LOCK);
+
+          pthread_mutex_lock(&STACK_LOCK);
+          stack_pop(args->locked, &element);
+          pthread_mutex_unlock(&STACK_LOCK);
+        }
+    }
+
+  return nullptr;
+}
+
+static void waitForStart(int threads)
+{
+  while (Ready.load() < threads)
+    sched_yield();
+
+  Go.store(1);
+}
+
+static uint32_t nextRandom(uint32_t *state)
+{
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+
+  return *state;
+}
+
+static uint64_t getNanoseconds()
+{
+  timespec now = {};
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
@@ -0,0 +1,384 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "logging.h"
+#include "timestamp.h"
+
+/// Call site from LOG_RECORD_SITE
+typedef struct {
+  char *strings; // name, fileName and functionName one after another
+  int   line;
+} Site;
+
+/// Decode binary log to text log
+/// @param [in] input Binary log
+/// @param [in] output Stream for text
+/// @param [in] precision Precision of time from TIMESTAMP_PRECISION
+/// @return 0 or 1 if log is broken
+static int decodeLog(FILE *input, FILE *output, TIMESTAMP_PRECISION precision);
+
+/// Get count of bytes from current position to end of file
+/// @param [in] input Stream
+/// @return Count of bytes or SIZE_MAX if stream can`t seek
+static size_t getBytesLeft(FILE *input);
+
+/// Save call site from body of LOG_RECORD_SITE
+/// @param [in/out] sites Pointer to array of sites
+/// @param [in/out] sitesCount Pointer to size of array
+/// @param [in] body Body of record
+/// @param [in] size Size of body
+/// @return 0 or 1 if record is broken
+static int saveSite(Site **sites, size_t *sitesCount, const char *body, size_t size);
+
+/// Print value from body of LOG_RECORD_VALUE as loggingPrint() does
+/// @param [in] output Stream for text
+/// @param [in] header Header of record
+/// @param [in] sites Array of sites
+/// @param [in] sitesCount Size of array
+/// @param [in] body Body of record
+/// @param [in] precision Precision of time from TIMESTAMP_PRECISION
+/// @return 0 or 1 if record is broken
+static int printValue(FILE *output, const LogRecordHeader *header,
+                      const Site *sites, size_t sitesCount, const char *body, TIMESTAMP_PRECISION precision);
+
+int main(int argc, char **argv)
+{
+  TIMESTAMP_PRECISION precision = TIMESTAMP_SECONDS;
+
+  if (argc > 1 && !strcmp(argv[1], "-u"))
+    {
+      precision = TIMESTAMP_MICROSECONDS;
+
+      --argc;
+      ++argv;
+    }
+
+  if (argc < 2)
+    {
+      fprintf(stderr, "Usage: %s [-u] binaryLog [textLog]\n"
+                      "  -u  print time with microseconds\n", argv[0]);
+
+      return 1;
+    }
+
+  FILE *input = fopen(argv[1], "rb");
+
+  if (!input)
+    {
+      fprintf(stderr, "Can`t open %s\n", argv[1]);
+
+      return 1;
+    }
+
+  FILE *output = argc > 2 ? fopen(argv[2], "w") : stdout;
+
+  if (!output)
+    {
+      fprintf(stderr, "Can`t open %s\n", argv[2]);
+
+      fclose(input);
+
+      return 1;
+    }
+
+  int result = decodeLog(input, output, precision);
+
+  if (result)
+    fprintf(stderr, "%s is broken\n", argv[1]);
+
+  fclose(input);
+
+  if (output != stdout)
+    fclose(output);
+
+  return result;
+}
+
+static int decodeLog(FILE *input, FILE *output, TIMESTAMP_PRECISION precision)
+{
+  char magic[sizeof(LOG_BINARY_MAGIC) - 1] = "";
+
+  if (fread(magic, 1, sizeof(magic), input) != sizeof(magic) || memcmp(magic, LOG_BINARY_MAGIC, sizeof(magic)))
+    return 1;
+
+  size_t bytesLeft  = getBytesLeft(input);
+
+  Site  *sites      = nullptr;
+  size_t sitesCount = 0;
+
+  char  *body       = nullptr;
+  size_t bodySize   = 0;
+
+  int    result     = 0;
+
+  LogRecordHeader header = {};
+
+  while (!result && fread(&header, sizeof(header), 1, input) == 1)
+    {
+      bytesLeft -= sizeof(header);
+
+      // Log can be cut by crash, so size isn`t trusted
+      if (header.size > bytesLeft || header.size > LOG_BUFFER_SIZE - sizeof(header))
+        {
+          result = 1;
+
+          break;
+        }
+
+      if ((size_t)header.size + 1 > bodySize)
+        {
+          char *newBody = (char *) realloc(body, (size_t)header.size + 1);
+
+          if (!newBody)
+            {
+              result = 1;
+
+              break;
+            }
+
+          body     = newBody;
+          bodySize = (size_t)header.size + 1;
+        }
+
+      if (fread(body, 1, header.size, input) != header.size)
+        {
+          result = 1;
+
+          break;
+        }
+
+      bytesLeft -= header.size;
+
+      body[header.size] = '\0';
+
+      switch (header.type)
+        {
+        case LOG_RECORD_TEXT:
+          fwrite(body, 1, header.size, output);
+          break;
+
+        case LOG_RECORD_SITE:
+          result = saveSite(&sites, &sitesCount, body, header.size);
+          break;
+
+        case LOG_RECORD_VALUE:
+          result = printValue(output, &header, sites, sitesCount, body, precision);
+          break;
+
+        default:
+          result = 1;
+          break;
+        }
+    }
+
+  for (size_t i = 0; i < sitesCount; ++i)
+    free(sites[i].strings);
+
+  free(sites);
+  free(body);
+
+  return result;
+}
+
+static size_t getBytesLeft(FILE *input)
+{
+  long position = ftell(input);
+
+  if (position < 0 || fseek(input, 0, SEEK_END))
+    return SIZE_MAX;
+
+  long end = ftell(input);
+
+  if (end < position || fseek(input, position, SEEK_SET))
+    return SIZE_MAX;
+
+  return (size_t)(end - position);
+}
+
+static int saveSite(Site **sites, size_t *sitesCount, const char *body, size_t size)
+{
+  LogSiteRecord record = {};
+
+  if (size < sizeof(record))
+    return 1;
+
+  memcpy(&record, body, sizeof(record));
+
+  if (record.site >= LOG_SITES_COUNT)
+    return 1;
+
+  if (record.site >= *sitesCount)
+    {
+      Site *newSites = (Site *) realloc(*sites, (record.site + 1) * sizeof(Site));
+
+      if (!newSites)
+        return 1;
+
+      memset(newSites + *sitesCount, 0, (record.site + 1 - *sitesCount) * sizeof(Site));
+
+      *sites      = newSites;
+      *sitesCount = record.site + 1;
+    }
+
+  Site *site = *sites + record.site;
+
+  // Site is written again to each new file
+  free(site->strings);
+
+  site->strings = (char *) malloc(size - sizeof(record) + 2);
+
+  if (!site->strings)
+    return 1;
+
+  // Two more zeros, so missing strings are empty
+  memcpy(site->strings, body + sizeof(record), size - sizeof(record));
+
+  site->strings[size - sizeof(record)]     = '\0';
+  site->strings[size - sizeof(record) + 1] = '\0';
+
+  site->line = record.line;
+
+  return 0;
+}
+
+static int printValue(FILE *output, const LogRecordHeader *header,
+                      const Site *sites, size_t sitesCount, const char *body, TIMESTAMP_PRECISION precision)
+{
+  LogValueRecord record = {};
+
+  if (header->size < sizeof(record))
+    return 1;
+
+  memcpy(&record, body, sizeof(record));
+
+  const char *name         = "unknown";
+  const char *fileName     = "unknown";
+  const char *functionName = "unknown";
+  int         line         = 0;
+
+  // Value can be written to new file right after rotation, when its site is in old file
+  if (record.site < sitesCount && sites[record.site].strings)
+    {
+      name         = sites[record.site].strings;
+      fileName     = name     + strlen(name)     + 1;
+      functionName = fileName + strlen(fileName) + 1;
+      line         = sites[record.site].line;
+    }
+
+  const char *value     = body + sizeof(record);
+  size_t      valueSize = header->size - sizeof(record);
+
+  char dataString[TIMESTAMP_SIZE] = "";
+
+  formatTimestamp(record.time, dataString, precision);
+
+  if (header->valueType == LOG_VALUE_STRING)
+    {
+      int length = (int) valueSize;
+
+      switch (header->level)
+        {
+        case VALUE:
+          fprintf(output, "[%s] File: %30s, Function: %60s, Line: %5d. C-like string value of '%s': \"%.*s\".",
+                  dataString, fileName, functionName, line, name, length, value);
+          break;
+
+        case MESSAGE:
+          fprintf(output, "[%s] File: %30s, Function: %60s, Line: %5d. Message: \"%.*s\".",
+                  dataString, fileName, functionName, line, length, value);
+          break;
+
+        case WARNING:
+          fprintf(output, "[%s] File: %30s, Function: %60s, Line: %5d. WARNING!!: \"%.*s\".",
+                  dataString, fileName, functionName, line, length, value);
+          break;
+
+        case ERROR:
+          fprintf(output, "[%s] File: %30s, Function: %60s, Line: %5d. ERROR!!: \"%.*s\".",
+                  dataString, fileName, functionName, line, length, value);
+          break;
+
+        case FATAL:
+          fprintf(output, "[%s] File: %30s, Function: %60s, Line: %5d. !!FATAL ERROR!!: \"%.*s\".",
+                  dataString, fileName, functionName, line, length, value);
+          break;
+
+        default:
+          fprintf(output, "Incorrect use of log functions!! File: %30s, Function: %60s, Line %5d.",
+                  fileName, functionName, line);
+          break;
+        }
+
+      return 0;
+    }
+
+  if (header->level != VALUE)
+    {
+      fprintf(output, "Incorrect use of log functions!! File: %30s, Function: %60s, Line: %5d.",
+              fileName, functionName, line);
+
+      return 0;
+    }
+
+  switch (header->valueType)
+    {
+    case LOG_VALUE_LONG_LONG:
+      {
+        long long number = 0;
+
+        if (valueSize != sizeof(number))
+          return 1;
+
+        memcpy(&number, value, sizeof(number));
+
+        fprintf(output, "[%s] File: %30s, Function: %60s, Line: %5d. Decimal value of '%s': %lld.",
+                dataString, fileName, functionName, line, name, number);
+        break;
+      }
+
+    case LOG_VALUE_DOUBLE:
+      {
+        double number = 0;
+
+        if (valueSize != sizeof(number))
+          return 1;
+
+        memcpy(&number, value, sizeof(number));
+
+        fprintf(output, "[%s] File: %30s, Function: %60s, Line: %5d. Double value of '%s': %lf.",
+                dataString, fileName, functionName, line, name, number);
+        break;
+      }
+
+    case LOG_VALUE_CHAR:
+      {
+        if (valueSize != sizeof(char))
+          return 1;
+
+        fprintf(output, "[%s] File: %30s, Function: %60s, Line: %5d. Char value of '%s': '%c'.",
+                dataString, fileName, functionName, line, name, *value);
+        break;
+      }
+
+    case LOG_VALUE_POINTER:
+      {
+        uint64_t address = 0;
+
+        if (valueSize != sizeof(address))
+          return 1;
+
+        memcpy(&address, value, sizeof(address));
+
+        fprintf(output, "[%s] File: %30s, Function: %60s, Line: %5d. Pointer value of '%s': %p.",
+                dataString, fileName, functionName, line, name, (void *) address);
+        break;
+      }
+
+    case LOG_VALUE_STRING:
+    default:
+      return 1;
+    }
+
+  return 0;
+}
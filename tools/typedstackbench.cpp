@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include <string>
+#include "typedstack.h"
+
+const size_t BENCH_ELEMENTS = 1000;
+const size_t BENCH_ROUNDS   = 1000;
+
+/// Element functions for strings in TypedStack
+template <>
+struct ElementTraits<std::string>
+{
+  static int print(const std::string *element, FILE *filePtr) { return fprintf(filePtr, "%s", element->c_str()); }
+};
+
+/// Copy int element for Stack
+/// @param [out] target Pointer to target element
+/// @param [in] source Pointer to source element
+static void copyInt(int *target, const int *source);
+
+/// Measure push and pop of C stack
+/// @param [in] rounds Count of rounds, each pushes and pops BENCH_ELEMENTS elements
+static void measureStack(size_t rounds);
+
+/// Measure push and pop of typed stack
+/// @param [in] name Name of case
+/// @param [in] rounds Count of rounds, each pushes and pops BENCH_ELEMENTS elements
+template <typename TypedIntStack>
+static void measureTyped(const char *name, size_t rounds);
+
+/// Check that strings are pushed and popped in right order
+/// @return 1 if they are or 0 if they aren`t
+static int checkStrings();
+
+/// Print time of one operation
+/// @param [in] name Name of case
+/// @param [in] elapsed Time of all rounds in nanoseconds
+/// @param [in] rounds Count of rounds
+/// @param [in] sum Sum of popped elements, it must be same in all cases
+static void printResult(const char *name, uint64_t elapsed, size_t rounds, long long sum);
+
+/// Get time of monotonic clock
+/// @return Time in nanoseconds
+static uint64_t getNanoseconds();
+
+int main()
+{
+  printf("%-36s %10s\n", "Case", "ns/op");
+
+  measureStack(BENCH_ROUNDS);
+
+  measureTyped<TypedStack<int>>("TypedStack<int>", BENCH_ROUNDS);
+  measureTyped<TypedStack<int, CanaryCheck, PoisonCheck>>("TypedStack<int, Canary, Poison>", BENCH_ROUNDS);
+  measureTyped<TypedStack<int, CanaryCheck, HashCheck, PoisonCheck, DumpCheck>>("TypedStack<int, all checks>",
+                                                                               BENCH_ROUNDS / 100);
+  measureTyped<ElementStack>("ElementStack", BENCH_ROUNDS);
+
+  printf("TypedStack<std::string>: %s\n", checkStrings() ? "ok" : "wrong order");
+
+  return 0;
+}
+
+static void copyInt(int *target, const int *source)
+{
+  *target = *source;
+}
+
+static void measureStack(size_t rounds)
+{
+  Stack stk = {};
+
+  stack_init(&stk, BENCH_ELEMENTS, copyInt);
+
+  long long sum = 0;
+
+  uint64_t start = getNanoseconds();
+
+  for (size_t round = 0; round < rounds; ++round)
+    {
+      for (int i = 0; i < (int)BENCH_ELEMENTS; ++i)
+        stack_push(&stk, &i);
+
+      for (size_t i = 0; i < BENCH_ELEMENTS; ++i)
+        {
+          int element = 0;
+
+          stack_pop(&stk, &element);
+
+          sum += element;
+        }
+    }
+
+  printResult("stack_push/stack_pop", getNanoseconds() - start, rounds, sum);
+
+  stack_destroy(&stk);
+}
+
+template <typename TypedIntStack>
+static void measureTyped(const char *name, size_t rounds)
+{
+  TypedIntStack stk;
+
+  typedstack_init(&stk, BENCH_ELEMENTS);
+
+  long long sum = 0;
+
+  uint64_t start = getNanoseconds();
+
+  for (size_t round = 0; round < rounds; ++round)
+    {
+      for (int i = 0; i < (int)BENCH_ELEMENTS; ++i)
+        stk.push(i);
+
+      for (size_t i = 0; i < BENCH_ELEMENTS; ++i)
+        {
+          int element = 0;
+
+          stk.pop(&element);
+
+          sum += element;
+        }
+    }
+
+  printResult(name, getNanoseconds() - start, rounds, sum);
+}
+
+static int checkStrings()
+{
+  TypedStack<std::string, CanaryCheck, HashCheck, DumpCheck> stk;
+
+  typedstack_init(&stk, 0);
+
+  for (size_t i = 0; i < BENCH_ELEMENTS; ++i)
+    stk.push(std::to_string(i));
+
+  for (size_t i = BENCH_ELEMENTS; i > 0; --i)
+    {
+      std::string element;
+
+      unsigned error = 0;
+
+      stk.pop(&element, &error);
+
+      if (error || element != std::to_string(i - 1))
+        return 0;
+    }
+
+  return stk.isEmpty() != 0;
+}
+
+static void printResult(const char *name, uint64_t elapsed, size_t rounds, long long sum)
+{
+  printf("%-36s %10.2f (sum %lld)\n", name, (double)elapsed / (double)(2 * rounds * BENCH_ELEMENTS),
+         sum / (long long)rounds);
+}
+
+static uint64_t getNanoseconds()
+{
+  timespec now = {};
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
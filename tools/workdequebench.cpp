@@ -0,0 +1,312 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <atomic>
+#include "workdeque.h"
+
+const int MAX_THREADS = 64;
+const int FIB_NUMBER  = 38;
+const int FIB_CUTOFF  = 12; // Tasks for smaller numbers are counted without forks
+
+/// Task queues which are compared in benchmark
+enum BENCH_TARGET {
+  BENCH_DEQUES, // WorkDeque per worker with stealing
+  BENCH_MUTEX,  // One Stack with global mutex for all workers
+};
+
+/// Arguments of worker thread
+typedef struct {
+  BENCH_TARGET target;
+  WorkDeque   *deques;
+  Stack       *shared;
+  int          id;
+  int          workers;
+  long long    sum;    // Sum of leaf tasks of this worker
+  size_t       steals; // Tasks which were stolen by this worker
+} WorkerArgs;
+
+static pthread_mutex_t STACK_LOCK = PTHREAD_MUTEX_INITIALIZER;
+
+static std::atomic<int>    Ready   {0};
+static std::atomic<int>    Go      {0};
+static std::atomic<size_t> Pending {0}; // Tasks which are pushed or running
+
+/// Copy int element
+/// @param [out] target Pointer to target element
+/// @param [in] source Pointer to source element
+static void copyInt(int *target, const int *source);
+
+/// Fibonacci number without tasks
+/// @param [in] number Number
+/// @return Fibonacci number
+static long long fibonacci(int number);
+
+/// Run tasks until all tasks are finished
+/// @param [in] worker Pointer to WorkerArgs
+/// @return nullptr
+static void *workerThread(void *worker);
+
+/// Take task for worker
+/// @param [in/out] args Arguments of worker
+/// @param [out] task Container for task
+/// @return 1 if task was taken or 0 if there were no tasks
+static int takeTask(WorkerArgs *args, int *task);
+
+/// Give task to worker`s queue
+/// @param [in/out] args Arguments of worker
+/// @param [in] task Task
+static void giveTask(WorkerArgs *args, int task);
+
+/// Count Fibonacci number by fork-join tasks and measure time
+/// @param [in] target Task queues for benchmark
+/// @param [in] workers Count of worker threads
+/// @param [out] steals Count of stolen tasks
+/// @return Time in milliseconds or negative value if result is wrong or memory wasn`t allocated
+static double runBench(BENCH_TARGET target, int workers, size_t *steals);
+
+/// Start all threads at once
+/// @param [in] threads Count of threads
+static void waitForStart(int threads);
+
+/// Get time of monotonic clock
+/// @return Time in nanoseconds
+static uint64_t getNanoseconds();
+
+int main(int argc, char *argv[])
+{
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+
+  int maxWorkers = argc > 1 ? atoi(argv[1]) : (int)(cores > 0 ? cores : 1);
+
+  if (maxWorkers < 1 || maxWorkers > MAX_THREADS)
+    {
+      fprintf(stderr, "Count of workers must be from 1 to %d\n", MAX_THREADS);
+
+      return 1;
+    }
+
+  printf("fib(%d), tasks below %d aren`t forked\n", FIB_NUMBER, FIB_CUTOFF);
+
+  printf("%-8s %12s %10s %10s %12s\n", "Workers", "Deques, ms", "Speedup", "Steals", "Mutex, ms");
+
+  double single = 0;
+
+  for (int workers = 1; ; workers *= 2)
+    {
+      if (workers > maxWorkers)
+        workers = maxWorkers;
+
+      size_t steals = 0;
+
+      double deques = runBench(BENCH_DEQUES, workers, &steals);
+      double locked = runBench(BENCH_MUTEX,  workers, nullptr);
+
+      if (deques < 0 || locked < 0)
+        {
+          printf("Wrong result or no memory with %d workers\n", workers);
+
+          return 1;
+        }
+
+      if (workers == 1)
+        single = deques;
+
+      printf("%-8d %12.1f %10.2f %10zu %12.1f\n", workers, deques, single / deques, steals, locked);
+
+      if (workers == maxWorkers)
+        break;
+    }
+
+  return 0;
+}
+
+static void copyInt(int *target, const int *source)
+{
+  *target = *source;
+}
+
+static long long fibonacci(int number)
+{
+  return number < 2 ? number : fibonacci(number - 1) + fibonacci(number - 2);
+}
+
+static double runBench(BENCH_TARGET target, int workers, size_t *steals)
+{
+  // Deques are large in debug builds, so they aren`t kept on thread stack
+  WorkDeque *deques = (WorkDeque *) calloc((size_t)workers, sizeof(WorkDeque));
+  Stack      shared = {};
+
+  if (!deques)
+    return -1;
+
+  if (target == BENCH_DEQUES)
+    for (int i = 0; i < workers; ++i)
+      workdeque_init(&deques[i], 0);
+  else
+    stack_init(&shared, 0, copyInt);
+
+  pthread_t  ids [MAX_THREADS] = {};
+  WorkerArgs args[MAX_THREADS] = {};
+
+  for (int i = 0; i < workers; ++i)
+    args[i] = {target, deques, &shared, i, workers, 0, 0};
+
+  Ready.store(0);
+  Go.store(0);
+  Pending.store(1);
+
+  // Root task is given before start, so workers don`t stop before it is taken
+  giveTask(&args[0], FIB_NUMBER);
+
+  for (int i = 0; i < workers; ++i)
+    pthread_create(&ids[i], nullptr, workerThread, &args[i]);
+
+  waitForStart(workers);
+
+  uint64_t start = getNanoseconds();
+
+  long long sum = 0;
+
+  for (int i = 0; i < workers; ++i)
+    {
+      pthread_join(ids[i], nullptr);
+
+      sum += args[i].sum;
+
+      if (steals)
+        *steals += args[i].steals;
+    }
+
+  uint64_t elapsed = getNanoseconds() - start;
+
+  if (target == BENCH_DEQUES)
+    for (int i = 0; i < workers; ++i)
+      workdeque_destroy(&deques[i]);
+  else
+    stack_destroy(&shared);
+
+  free(deques);
+
+  static long long expected = fibonacci(FIB_NUMBER);
+
+  if (sum != expected)
+    return -1;
+
+  return (double)elapsed / 1e6;
+}
+
+static void *workerThread(void *worker)
+{
+  WorkerArgs *args = (WorkerArgs *)worker;
+
+  ++Ready;
+
+  while (!Go.load())
+    sched_yield();
+
+  while (Pending.load(std::memory_order_acquire))
+    {
+      int task = 0;
+
+      if (!takeTask(args, &task))
+        {
+          sched_yield();
+
+          continue;
+        }
+
+      if (task < FIB_CUTOFF)
+        {
+          args->sum += fibonacci(task);
+
+          Pending.fetch_sub(1, std::memory_order_release);
+
+          continue;
+        }
+
+      // Task is replaced by two tasks
+      Pending.fetch_add(1, std::memory_order_relaxed);
+
+      giveTask(args, task - 2);
+      giveTask(args, task - 1);
+    }
+
+  return nullptr;
+}
+
+static int takeTask(WorkerArgs *args, int *task)
+{
+  unsigned error = 0;
+
+  if (args->target == BENCH_MUTEX)
+    {
+      pthread_mutex_lock(&STACK_LOCK);
+
+      if (!stack_isEmpty(args->shared))
+        stack_pop(args->shared, task, &error);
+      else
+        error = 1;
+
+      pthread_mutex_unlock(&STACK_LOCK);
+
+      return !error;
+    }
+
+  workdeque_pop(&args->deques[args->id], task, &error);
+
+  if (!error)
+    return 1;
+
+  // Own deque is empty, so steal oldest and largest task of other worker
+  for (int i = 1; i < args->workers; ++i)
+    {
+      WorkDeque *victim = &args->deques[(args->id + i) % args->workers];
+
+      int result = STEAL_ABORT;
+
+      while (result == STEAL_ABORT)
+        result = workdeque_steal(victim, task);
+
+      if (result == STEAL_SUCCESS)
+        {
+          ++args->steals;
+
+          return 1;
+        }
+    }
+
+  return 0;
+}
+
+static void giveTask(WorkerArgs *args, int task)
+{
+  if (args->target == BENCH_MUTEX)
+    {
+      pthread_mutex_lock(&STACK_LOCK);
+      stack_push(args->shared, &task);
+      pthread_mutex_unlock(&STACK_LOCK);
+    }
+  else
+    workdeque_push(&args->deques[args->id], &task);
+}
+
+static void waitForStart(int threads)
+{
+  while (Ready.load() < threads)
+    sched_yield();
+
+  Go.store(1);
+}
+
+static uint64_t getNanoseconds()
+{
+  timespec now = {};
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}